@@ -1,240 +1,1772 @@
 #include "ccore/c_debug.h"
-#include "ccore/c_qsort.h"
-#include "ccore/c_binary_search.h"
+#include "ccore/c_allocator.h"
 
 #include "crtti/c_type_info.h"
+#include "crtti/c_type_registry.h"
+#include "crtti/c_rttr_filter.h"
+#include "crtti/impl/c_ancestor_scan.h"
 
-#define RTTR_MAX_TYPE_COUNT          8192
-#define RTTR_TMP_TYPE_COUNT          64
-#define RTTR_MAX_INHERIT_TYPES_COUNT 32
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <new>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <type_traits>
+
+#define RTTR_TYPE_CHUNK_SHIFT        8
+#define RTTR_TYPE_CHUNK_SIZE         (1 << RTTR_TYPE_CHUNK_SHIFT)  // Number of types per storage chunk
+#define RTTR_TYPE_CHUNK_MASK         (RTTR_TYPE_CHUNK_SIZE - 1)
+#if RTTR_TYPE_ID_BITS == 32
+#    define RTTR_MAX_TYPE_COUNT      (1 << 20)  // Bounds the chunk directory (4096 pointers), not the id range
+#else
+#    define RTTR_MAX_TYPE_COUNT      65536  // The full range of type_id_t
+#endif
+#define RTTR_MAX_CHUNK_COUNT         (RTTR_MAX_TYPE_COUNT / RTTR_TYPE_CHUNK_SIZE)
+#define RTTR_MIN_HASH_INDEX_SIZE     64   // Power of two, the index doubles whenever its load factor would exceed 0.5
+#define RTTR_MIN_ANCESTOR_CAPACITY   256  // The ancestor table doubles whenever it is full
+#define RTTR_SEALED_BUCKET_LOAD      4        // Average number of names per displacement bucket of the sealed index
+#define RTTR_SEALED_MAX_DISPLACEMENT (1 << 20)  // Give up sealing when a bucket does not fit after this many tries
+#define RTTR_NAME_BLOCK_SIZE         (16 * 1024)  // Bytes per block of the name arena, a longer name gets a block of its own
+#define RTTR_SNAPSHOT_MAGIC          0x53545452  // 'RTTS'
+#define RTTR_SNAPSHOT_VERSION        3
+#define RTTR_TRACE_MAGIC             0x45545452  // 'RTTE'
+#define RTTR_TRACE_VERSION           1
 
 namespace ncore
 {
     namespace nrtti
     {
+#if RTTR_ENABLE_CAST_CACHE
+        static_assert(RTTR_CAST_CACHE_SIZE > 0 && RTTR_CAST_CACHE_SIZE <= 64 && (RTTR_CAST_CACHE_SIZE & (RTTR_CAST_CACHE_SIZE - 1)) == 0, "RTTR_CAST_CACHE_SIZE must be a power of two, at most 64");
+
+        // Direct-mapped cache of isTypeDerivedFrom results, every thread has its own. A key holds
+        // both type ids, 0 marks an empty entry (two invalid types are equal, they never get here).
+        // The result of entry i is bit i of m_results.
+        struct cast_cache_t
+        {
+            u32 m_epoch;
+            u64 m_hits;
+            u64 m_misses;
+            u64 m_results;
+            u64 m_keys[RTTR_CAST_CACHE_SIZE];
+        };
+
+        static thread_local cast_cache_t s_cast_cache;
+
+        // Bumped on every change to the registry, a thread that sees a different value than the one
+        // its cache was filled under empties the cache. This also drops results that were computed
+        // for an id that was not registered yet, or for an id of a registry that has been popped.
+        static std::atomic<u32> s_cast_cache_epoch(0);
+
+        static inline void s_invalidate_cast_caches() { s_cast_cache_epoch.fetch_add(1, std::memory_order_release); }
+#else
+        static inline void s_invalidate_cast_caches() {}
+#endif
+
+        // The system heap, the allocator of the registry until setRegistryAllocator() sets another. A block
+        // is over-allocated to align it, the pointer malloc returned is kept in front of the block.
+        class heap_alloc_t : public alloc_t
+        {
+        protected:
+            virtual void *v_allocate(u32 size, u32 alignment)
+            {
+                if (alignment < sizeof(void *))
+                    alignment = sizeof(void *);
+                void *block = ::malloc((size_t)size + alignment + sizeof(void *));
+                if (block == nullptr)
+                    return nullptr;
+                size_t const aligned   = ((size_t)block + sizeof(void *) + alignment - 1) & ~(size_t)(alignment - 1);
+                ((void **)aligned)[-1] = block;
+                return (void *)aligned;
+            }
+            virtual void v_deallocate(void *ptr)
+            {
+                if (ptr != nullptr)
+                    ::free(((void **)ptr)[-1]);
+            }
+            virtual void v_release() {}
+        };
+
+        // Function local, so it exists before the first static initializer registers a type
+        static alloc_t *s_heap_alloc()
+        {
+            static heap_alloc_t heap;
+            return &heap;
+        }
+
+        static std::atomic<alloc_t *> s_registry_allocator(nullptr);
+
+        // The allocator a registry made now gets
+        static alloc_t *s_current_allocator()
+        {
+            alloc_t *allocator = s_registry_allocator.load(std::memory_order_acquire);
+            return allocator != nullptr ? allocator : s_heap_alloc();
+        }
+
+        // All memory of the registry, its temporary buffers, the derived_type_set_t bitsets and the trace
+        // buffers comes from an alloc_t. Objects are value-initialized (zeroed for plain data), arrays are
+        // only for types without a destructor.
+        template <typename T>
+        static T *s_new(alloc_t *allocator)
+        {
+            return new (allocator->allocate((u32)sizeof(T), (u32)alignof(T))) T();
+        }
+
+        template <typename T>
+        static void s_delete(alloc_t *allocator, T *object)
+        {
+            if (object == nullptr)
+                return;
+            object->~T();
+            allocator->deallocate(object);
+        }
+
+        template <typename T>
+        static T *s_new_array(alloc_t *allocator, u32 count)
+        {
+            T *array = (T *)allocator->allocate((u32)(sizeof(T) * count), (u32)alignof(T));
+            for (u32 i = 0; i < count; ++i)
+                new (array + i) T();
+            return array;
+        }
+
+        template <typename T>
+        static void s_delete_array(alloc_t *allocator, T *array)
+        {
+            static_assert(std::is_trivially_destructible<T>::value, "arrays are released without destructors");
+            if (array != nullptr)
+                allocator->deallocate(array);
+        }
+
+        // The clock of the timing histograms and of the trace
+        static inline u64 s_now_ns() { return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+#if RTTR_ENABLE_STATS
+        // The counters of registry_counters_t are addressed by their index in the structure, a histogram
+        // is m_calls, m_total_ns and the buckets at consecutive indices.
+        enum
+        {
+            STATS_COUNTER_COUNT = sizeof(registry_counters_t) / sizeof(u64)
+        };
+
+        // Every thread counts into its own shard. Only the owner writes it, with a plain load and store,
+        // getRegistryCounters reads all of them. The shards are linked under s_stats_lock, the counts of
+        // a thread that exits are added to s_stats_retired.
+        struct stats_shard_t
+        {
+            stats_shard_t();
+            ~stats_shard_t();
+
+            std::atomic<u64> m_values[STATS_COUNTER_COUNT];
+            stats_shard_t   *m_prev;
+            stats_shard_t   *m_next;
+        };
+
+        static std::mutex     s_stats_lock;
+        static stats_shard_t *s_stats_shards = nullptr;
+        static u64            s_stats_retired[STATS_COUNTER_COUNT];
+
+        stats_shard_t::stats_shard_t()
+        {
+            for (u32 i = 0; i < STATS_COUNTER_COUNT; ++i)
+                m_values[i].store(0, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lock(s_stats_lock);
+            m_prev = nullptr;
+            m_next = s_stats_shards;
+            if (m_next != nullptr)
+                m_next->m_prev = this;
+            s_stats_shards = this;
+        }
+
+        stats_shard_t::~stats_shard_t()
+        {
+            std::lock_guard<std::mutex> lock(s_stats_lock);
+            for (u32 i = 0; i < STATS_COUNTER_COUNT; ++i)
+                s_stats_retired[i] += m_values[i].load(std::memory_order_relaxed);
+            if (m_prev != nullptr)
+                m_prev->m_next = m_next;
+            else
+                s_stats_shards = m_next;
+            if (m_next != nullptr)
+                m_next->m_prev = m_prev;
+        }
+
+        static stats_shard_t &s_stats_shard()
+        {
+            static thread_local stats_shard_t shard;
+            return shard;
+        }
+
+        static inline void s_stats_add(u32 counter, u64 n)
+        {
+            std::atomic<u64> &value = s_stats_shard().m_values[counter];
+            value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        static void s_stats_time(u32 histogram, u64 start)
+        {
+            u64 const ns     = s_now_ns() - start;
+            u32       bucket = 0;
+            while (bucket + 1 < RTTR_STATS_HISTOGRAM_SIZE && (ns >> (bucket + 1)) != 0)
+                bucket++;
+            s_stats_add(histogram, 1);
+            s_stats_add(histogram + 1, ns);
+            s_stats_add(histogram + 2 + bucket, 1);
+        }
+
+        // Adds the duration of its scope to a histogram
+        struct stats_timer_t
+        {
+            stats_timer_t(u32 histogram)
+                : m_histogram(histogram)
+                , m_start(s_now_ns())
+            {
+            }
+            ~stats_timer_t() { s_stats_time(m_histogram, m_start); }
+
+            u32 m_histogram;
+            u64 m_start;
+        };
+
+#    define RTTR_STATS_COUNTER(field) ((u32)(offsetof(registry_counters_t, field) / sizeof(u64)))
+#    define RTTR_STATS_ADD(field, n)  s_stats_add(RTTR_STATS_COUNTER(field), (n))
+#    define RTTR_STATS_TIME(field)    stats_timer_t statsTimer(RTTR_STATS_COUNTER(field))
+#else
+#    define RTTR_STATS_ADD(field, n) \
+        do                           \
+        {                            \
+        } while (0)
+#    define RTTR_STATS_TIME(field) \
+        do                         \
+        {                          \
+        } while (0)
+#endif
+
+#if RTTR_ENABLE_TRACE
+        static_assert(RTTR_TRACE_BUFFER_SIZE > 0 && (RTTR_TRACE_BUFFER_SIZE & (RTTR_TRACE_BUFFER_SIZE - 1)) == 0, "RTTR_TRACE_BUFFER_SIZE must be a power of two");
+
+        namespace impl
+        {
+            std::atomic<bool> g_traceEnabled(false);
+        }
+
+        // The ring buffer of one thread. An event is packed in two words, the time with the op and the
+        // result in the top byte, and both ids. Only the owner writes, a drain can run on any thread at
+        // the same time, like a seqlock: m_begin is bumped before a slot is overwritten and m_end after,
+        // a drain drops the events it copied from slots that m_begin shows were overwritten meanwhile.
+        struct trace_ring_t
+        {
+            std::atomic<u64> m_begin;    // Number of events the owner started to write
+            std::atomic<u64> m_end;      // Number of events the owner finished writing
+            u64              m_drained;  // Number of events drained, under s_trace_lock
+            u16              m_thread;
+            bool             m_retired;  // The owner exited, the ring is freed once drained
+            trace_ring_t    *m_next;
+            alloc_t         *m_allocator;
+            std::atomic<u64> m_slots[RTTR_TRACE_BUFFER_SIZE][2];
+        };
+
+        static std::mutex    s_trace_lock;
+        static trace_ring_t *s_trace_rings = nullptr;
+        static u16           s_trace_threads = 0;
+
+        // Owns the ring of a thread, hands it over to the drain when the thread exits
+        struct trace_ring_owner_t
+        {
+            trace_ring_owner_t()
+                : m_ring(nullptr)
+            {
+            }
+            ~trace_ring_owner_t()
+            {
+                if (m_ring == nullptr)
+                    return;
+                std::lock_guard<std::mutex> lock(s_trace_lock);
+                m_ring->m_retired = true;
+            }
+
+            trace_ring_t *m_ring;
+        };
+
+        static thread_local trace_ring_owner_t s_trace_ring;
+
+        static trace_ring_t *s_new_trace_ring()
+        {
+            alloc_t *const              allocator = s_current_allocator();
+            trace_ring_t               *ring      = s_new<trace_ring_t>(allocator);  // zeroed
+            ring->m_allocator                     = allocator;
+            std::lock_guard<std::mutex> lock(s_trace_lock);
+            ring->m_thread = s_trace_threads++;
+            ring->m_next   = s_trace_rings;
+            s_trace_rings  = ring;
+            return ring;
+        }
+
+#    define RTTR_TRACE(op, source, target, result)                    \
+        do                                                            \
+        {                                                             \
+            if (impl::isTracing())                                    \
+                impl::traceEvent((op), (source), (target), (result)); \
+        } while (0)
+#else
+#    define RTTR_TRACE(op, source, target, result) \
+        do                                         \
+        {                                          \
+        } while (0)
+#endif
+
         struct type_info_data_t
         {
+            // Everything a cast or a query of a type_info_t reads, packed in one record so a query of
+            // a type that is not in the cache costs one cache line. A registered type has a raw type
+            // (itself or the type it is a variant of), an unregistered one has 0.
+            struct type_record_t
+            {
+                u32       m_ancestorOffset;  // First ancestor of the type in the ancestor table
+                u32       m_ancestorMask;    // Bloom mask of the ancestors that are not on the primary chain
+                type_id_t m_rawType;
+                u16       m_ancestorCount;  // Number of ancestors of the type
+                u16       m_depth;          // Length of the primary chain (first base, its first base, ...)
+                u16       m_generation;     // Number of times the id was reused
+            };
+#if RTTR_TYPE_ID_BITS == 16
+            static_assert(sizeof(type_record_t) == 16, "four records of 16-bit type ids fit in a cache line");
+#endif
+
+            // The per type data is stored in chunks that are allocated on demand, a chunk never
+            // moves once allocated so type ids stay valid indices while the registry grows. The hot
+            // records come first, the names and hashes are only read by lookups by name and writers.
+            struct type_chunk_t
+            {
+                type_record_t records[RTTR_TYPE_CHUNK_SIZE];
+                u64           hashList[RTTR_TYPE_CHUNK_SIZE];
+                const char   *nameList[RTTR_TYPE_CHUNK_SIZE];
+                u32           nameLength[RTTR_TYPE_CHUNK_SIZE];        // Length of the name, without the terminating zero
+                u16           ancestorCapacity[RTTR_TYPE_CHUNK_SIZE];  // Size of the span, a reused id keeps the span when the new ancestors fit
+            };
+
+            // All ancestor sets packed back to back, every type refers to its own span by offset and count.
+            // Like the name index, a full table is replaced by a bigger copy and the old one is retired.
+            //
+            // A span starts with the primary chain, nearest first, so the ancestor with depth d of a type
+            // with depth D is found at index D - 1 - d (a Cohen display). This makes the subtype check
+            // for single inheritance O(1). Ancestors reached through other bases follow the chain.
+            struct ancestor_table_t
+            {
+                u32               m_capacity;
+                type_id_t        *m_ids;
+                ancestor_table_t *m_retired;
+            };
+
+            // An entry of the open-addressing name index, an id of 0 marks an empty slot.
+            // The id is published last (release), so a reader that sees a non-zero id also
+            // sees the hash and all the data of that type. An unregistered type leaves its id
+            // with a hash of 0 (a tombstone), the probe sequences that pass it stay intact. A
+            // tombstone is reused by publishing the hash last instead.
+            struct hash_slot_t
+            {
+                std::atomic<u64>       m_hash;
+                std::atomic<type_id_t> m_id;
+            };
+
+            // When the index grows a new one is published, the old one is kept alive until the
+            // registry is destroyed since lock-free readers might still be probing it.
+            struct hash_index_t
+            {
+                u32           m_size;  // Power of two
+                hash_slot_t  *m_slots;
+                hash_index_t *m_retired;
+            };
+
+            // An id reserved by a hotness profile, the id is set to 0 once its type has taken it. Only the
+            // writer looks at these, under writeLock.
+            struct profile_slot_t
+            {
+                u64       m_hash;
+                type_id_t m_id;
+            };
+
+            // A record of the sealed index, two records share a cache line and a record never straddles one
+            struct alignas(32) sealed_record_t
+            {
+                u64         m_hash;
+                const char *m_name;
+                u32         m_length;
+                type_id_t   m_id;
+            };
+
+            // The read-only name index built by seal(), a minimal perfect hash (hash and displace) over the
+            // name hashes: a name hash picks a bucket, the displacement of that bucket picks the one record
+            // that can hold the name. Once a type is registered after sealing the index is marked stale,
+            // from then on a lookup that misses here also probes the regular index.
+            struct sealed_index_t
+            {
+                u32               m_size;         // Number of records
+                u32               m_bucketCount;  // Number of displacements
+                u32              *m_displacements;
+                sealed_record_t  *m_records;
+                std::atomic<bool> m_stale;
+                sealed_index_t   *m_retired;
+            };
+
+            // Names that are copied into the registry are packed back to back in blocks, a block never
+            // moves so a name can be handed out as a pointer. Names that are registered one after the
+            // other, like the variants of a type, end up next to each other.
+            struct name_block_t
+            {
+                u32           m_size;
+                u32           m_used;
+                char         *m_data;
+                name_block_t *m_next;  // The block that was filled before this one
+            };
+
+            // A snapshot image starts with this header, followed by the per type arrays, the ancestor
+            // table, the slots of the name index and the names. Everything is stored as ids or offsets
+            // into the image, every array starts at a multiple of 8 bytes.
+            struct snapshot_header_t
+            {
+                u32 m_magic;
+                u32 m_version;
+                u32 m_idSize;         // sizeof(type_id_t)
+                u32 m_typeCount;      // Including the invalid type (id 0)
+                u32 m_ancestorCount;  // Entries of the ancestor table
+                u32 m_indexSize;      // Slots of the name index
+                u32 m_nameBytes;      // Bytes of all names, including their terminating zero
+                u32 m_reserved;
+            };
+
+            // Byte offsets of the arrays of an image, computed from its header
+            struct snapshot_layout_t
+            {
+                u64 m_hashes;
+                u64 m_rawTypes;
+                u64 m_ancestorOffsets;
+                u64 m_ancestorCounts;
+                u64 m_depths;
+                u64 m_masks;
+                u64 m_nameOffsets;
+                u64 m_ancestors;
+                u64 m_index;
+                u64 m_names;
+                u64 m_size;
+            };
+
             type_info_data_t()
-                : globalIDCounter(0)
+                : globalIDCounter(1)  // id 0 is the invalid type
+                , chunkCount(0)
+                , ancestorCount(0)
+                , stableIdCollisions(0)
+                , snapshotTypeCount(0)
+                , snapshotMismatches(0)
+                , sealedTypeCount(0)
+                , allocatedBytes(sizeof(type_info_data_t))
+                , nameArenaBytes(0)
+                , nameBlocks(nullptr)
+                , indexUsed(0)
+                , freeCount(0)
+                , freeCapacity(0)
+                , freeIds(nullptr)
+                , removedTypes(0)
+                , profileSize(0)
+                , profilePending(0)
+                , profileSlots(nullptr)
+                , sealedRetired(nullptr)
+                , previous(nullptr)
+                , allocator(s_current_allocator())
+            {
+                sealedIndex.store(nullptr, std::memory_order_relaxed);
+                for (u32 i = 0; i < RTTR_MAX_CHUNK_COUNT; ++i)
+                    chunks[i].store(nullptr, std::memory_order_relaxed);
+                hashIndex.store(new_hash_index(RTTR_MIN_HASH_INDEX_SIZE, nullptr), std::memory_order_relaxed);
+                ancestors.store(new_ancestor_table(RTTR_MIN_ANCESTOR_CAPACITY, nullptr), std::memory_order_relaxed);
+
+                type_chunk_t *first        = add_chunk();
+                first->hashList[0]         = 0;
+                first->nameList[0]         = "Invalid type_info_t";
+                first->nameLength[0]       = s_name_length(first->nameList[0]);
+                first->ancestorCapacity[0] = 0;
+                first->records[0]          = type_record_t();
+            }
+
+            ~type_info_data_t()
+            {
+                for (u32 i = 0; i < chunkCount; ++i)
+                    s_delete(allocator, chunks[i].load(std::memory_order_relaxed));
+
+                hash_index_t *index = hashIndex.load(std::memory_order_relaxed);
+                while (index != nullptr)
+                {
+                    hash_index_t *retired = index->m_retired;
+                    s_delete_array(allocator, index->m_slots);
+                    s_delete(allocator, index);
+                    index = retired;
+                }
+
+                ancestor_table_t *table = ancestors.load(std::memory_order_relaxed);
+                while (table != nullptr)
+                {
+                    ancestor_table_t *retired = table->m_retired;
+                    s_delete_array(allocator, table->m_ids);
+                    s_delete(allocator, table);
+                    table = retired;
+                }
+
+                sealed_index_t *chains[2] = {sealedIndex.load(std::memory_order_relaxed), sealedRetired};
+                for (u32 c = 0; c < 2; ++c)
+                {
+                    sealed_index_t *sealed = chains[c];
+                    while (sealed != nullptr)
+                    {
+                        sealed_index_t *retired = sealed->m_retired;
+                        s_delete_array(allocator, sealed->m_displacements);
+                        s_delete_array(allocator, sealed->m_records);
+                        s_delete(allocator, sealed);
+                        sealed = retired;
+                    }
+                }
+
+                s_delete_array(allocator, freeIds);
+                s_delete_array(allocator, profileSlots);
+
+                while (nameBlocks != nullptr)
+                {
+                    name_block_t *next = nameBlocks->m_next;
+                    s_delete_array(allocator, nameBlocks->m_data);
+                    s_delete(allocator, nameBlocks);
+                    nameBlocks = next;
+                }
+            }
+
+            static type_info_data_t *&current()
+            {
+                static type_info_data_t  obj;
+                static type_info_data_t *cur = &obj;
+                return cur;
+            }
+
+            static type_info_data_t &instance() { return *current(); }
+
+            // The C library scans a word or vector at a time, a terminated name only costs one pass more than a slice
+            static inline u32 s_name_length(const char *name) { return (u32)strlen(name); }
+
+            // 8 bytes of a name as a little-endian word, compilers turn this into a single load
+            static inline u64 s_load_word(const char *name)
+            {
+                return (u64)(u8)name[0] | ((u64)(u8)name[1] << 8) | ((u64)(u8)name[2] << 16) | ((u64)(u8)name[3] << 24) | ((u64)(u8)name[4] << 32) | ((u64)(u8)name[5] << 40) | ((u64)(u8)name[6] << 48) | ((u64)(u8)name[7] << 56);
+            }
+
+            // The last 1 to 7 bytes of a name, zero padded, without reading past the name
+            static inline u64 s_load_tail(const char *name, u32 bytes)
+            {
+                u64 word = 0;
+                while (bytes > 0)
+                {
+                    --bytes;
+                    word = (word << 8) | (u8)name[bytes];
+                }
+                return word;
+            }
+
+            static inline u64 s_hash_shift(u64 hash, u32 shift) { return hash ^ (hash >> shift); }
+
+            // Also the stable id of a type, must give the same value as impl::stableIdOf
+            static u64 s_hash_name(const char *name, u32 length)
+            {
+                u64 hash = 14695981039346656037ULL ^ ((u64)length * 0x9E3779B97F4A7C15ULL);
+                for (; length >= 8; length -= 8, name += 8)
+                    hash = s_hash_shift((hash ^ s_load_word(name)) * 0x9E3779B97F4A7C15ULL, 29);
+                if (length > 0)
+                    hash = s_hash_shift((hash ^ s_load_tail(name, length)) * 0x9E3779B97F4A7C15ULL, 29);
+                return s_hash_shift(s_hash_shift(s_hash_shift(hash, 31) * 0xBF58476D1CE4E5B9ULL, 29) * 0x94D049BB133111EBULL, 32);
+            }
+
+            // Both names have \a length characters
+            static bool s_equal_names(const char *nameA, const char *nameB, u32 length)
+            {
+                for (; length >= 8; length -= 8, nameA += 8, nameB += 8)
+                {
+                    if (s_load_word(nameA) != s_load_word(nameB))
+                        return false;
+                }
+                return s_load_tail(nameA, length) == s_load_tail(nameB, length);
+            }
+
+            // The chunk of a type id that was handed out, the chunk was published before the id
+            inline type_chunk_t *chunk(type_id_t id) const { return chunks[id >> RTTR_TYPE_CHUNK_SHIFT].load(std::memory_order_acquire); }
+
+            inline const char *name(type_id_t id) const { return chunk(id)->nameList[id & RTTR_TYPE_CHUNK_MASK]; }
+            inline u32         nameLength(type_id_t id) const { return chunk(id)->nameLength[id & RTTR_TYPE_CHUNK_MASK]; }
+            inline u64         hash(type_id_t id) const { return chunk(id)->hashList[id & RTTR_TYPE_CHUNK_MASK]; }
+            inline type_record_t const &record(type_id_t id) const { return chunk(id)->records[id & RTTR_TYPE_CHUNK_MASK]; }
+            inline type_id_t            rawType(type_id_t id) const { return record(id).m_rawType; }
+            inline u16                  generation(type_id_t id) const { return record(id).m_generation; }
+
+            // Reads the generation of an id that a lookup found without the lock. The type can be removed and its
+            // id taken by another type in between, its hash tells, the id is not found then.
+            inline type_id_t found(type_id_t id, u64 hash, u16 &generation) const
+            {
+                generation = this->generation(id);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (this->hash(id) == hash)
+                    return id;
+                generation = 0;
+                return 0;
+            }
+
+            // A registered type has a raw type and the current generation of its id
+            inline bool isRegistered(type_id_t id, u16 generation) const
+            {
+                if (id == 0)
+                    return false;
+                type_record_t const &r = record(id);
+                return r.m_generation == generation && r.m_rawType != 0;
+            }
+
+            // A type_info_t of a removed type keeps its id while another type takes the id over, only the
+            // generation tells them apart. Until a type is removed no type_info_t can be stale.
+            inline bool isCurrent(type_id_t id, u16 generation) const { return removedTypes.load(std::memory_order_relaxed) == 0 || this->generation(id) == generation; }
+
+            inline u16 depth(type_id_t rawId) const { return record(rawId).m_depth; }
+
+            // The ancestors of a raw type, the span was written before the type id was published
+            inline type_id_t const *ancestorList(type_record_t const &raw, u32 &count) const
+            {
+                count = raw.m_ancestorCount;
+                return ancestors.load(std::memory_order_acquire)->m_ids + raw.m_ancestorOffset;
+            }
+
+            static inline u32 s_ancestor_bit(type_id_t id) { return (u32)1 << (((u32)id * 2654435761u) >> 27); }
+
+            type_chunk_t *add_chunk()
+            {
+                type_chunk_t *chunk = s_new<type_chunk_t>(allocator);  // zeroed, a new id starts at generation 0
+                chunks[chunkCount].store(chunk, std::memory_order_release);
+                chunkCount += 1;
+                allocatedBytes += sizeof(type_chunk_t);
+                return chunk;
+            }
+
+            hash_index_t *new_hash_index(u32 size, hash_index_t *retired)
+            {
+                hash_index_t *index = s_new<hash_index_t>(allocator);
+                index->m_size       = size;
+                index->m_slots      = s_new_array<hash_slot_t>(allocator, size);
+                index->m_retired    = retired;
+                for (u32 i = 0; i < size; ++i)
+                {
+                    index->m_slots[i].m_hash.store(0, std::memory_order_relaxed);
+                    index->m_slots[i].m_id.store(0, std::memory_order_relaxed);
+                }
+                allocatedBytes += sizeof(hash_index_t) + size * sizeof(hash_slot_t);
+                return index;
+            }
+
+            ancestor_table_t *new_ancestor_table(u32 capacity, ancestor_table_t *retired)
+            {
+                ancestor_table_t *table = s_new<ancestor_table_t>(allocator);
+                table->m_capacity       = capacity;
+                table->m_ids            = s_new_array<type_id_t>(allocator, capacity);
+                table->m_retired        = retired;
+                allocatedBytes += sizeof(ancestor_table_t) + capacity * sizeof(type_id_t);
+                return table;
+            }
+
+            // Writers must hold writeLock, copies a name into the arena and terminates it
+            const char *intern_name(const char *name, u32 length)
+            {
+                name_block_t *block = nameBlocks;
+                if (block == nullptr || block->m_size - block->m_used < length + 1)
+                {
+                    u32 const size  = (length + 1 > RTTR_NAME_BLOCK_SIZE) ? length + 1 : RTTR_NAME_BLOCK_SIZE;
+                    block           = s_new<name_block_t>(allocator);
+                    block->m_size   = size;
+                    block->m_used   = 0;
+                    block->m_data   = s_new_array<char>(allocator, size);
+                    block->m_next   = nameBlocks;
+                    nameBlocks      = block;
+                    nameArenaBytes += sizeof(name_block_t) + size;
+                    allocatedBytes += sizeof(name_block_t) + size;
+                }
+
+                char *copy = block->m_data + block->m_used;
+                for (u32 i = 0; i < length; ++i)
+                    copy[i] = name[i];
+                copy[length] = 0;
+                block->m_used += length + 1;
+                return copy;
+            }
+
+            // Makes room for a span of up to \a count ancestors at the end of the table, growing it when needed.
+            // The span is not visible to readers until a type that refers to it is published.
+            type_id_t *reserve_ancestors(u32 count)
+            {
+                ancestor_table_t *table = ancestors.load(std::memory_order_relaxed);
+                if (ancestorCount + count > table->m_capacity)
+                {
+                    u32 capacity = table->m_capacity * 2;
+                    while (ancestorCount + count > capacity)
+                        capacity *= 2;
+                    ancestor_table_t *grown = new_ancestor_table(capacity, table);
+                    for (u32 i = 0; i < ancestorCount; ++i)
+                        grown->m_ids[i] = table->m_ids[i];
+                    ancestors.store(grown, std::memory_order_release);
+                    table = grown;
+                }
+                return table->m_ids + ancestorCount;
+            }
+
+            // The most ancestors a type with these base classes can have, the size of the span build_ancestors needs
+            u32 ancestor_bound(const type_info_t *baseClassList, u32 numBaseClasses) const { return numBaseClasses == 0 ? 0 : numBaseClasses + depth(rawType(baseClassList[0].getId())); }
+
+            // Writes the ancestor span of a new type: the primary chain through the first base, followed
+            // by the ancestors that are not on that chain. Every ancestor is stored once, the ones off
+            // the chain are ordered by depth so the nearest bases are checked first. Returns the number
+            // of ids written, \a span has room for ancestor_bound() ids.
+            u32 build_ancestors(const type_info_t *baseClassList, u32 numBaseClasses, type_id_t *span, u16 &outDepth, u32 &outMask)
+            {
+                outDepth = 0;
+                outMask  = 0;
+                if (numBaseClasses == 0)
+                    return 0;
+
+                type_id_t const first      = rawType(baseClassList[0].getId());
+                u16 const       firstDepth = depth(first);
+
+                u32              chainCount;
+                type_id_t const *chain = ancestorList(record(first), chainCount);
+                u32              count = 0;
+                span[count++]          = first;
+                for (u32 i = 0; i < firstDepth; ++i)
+                    span[count++] = chain[i];
+                outDepth = (u16)count;
+
+                // the flattened base class list also contains the chain, and in diamond hierarchies
+                // the same ancestor more than once, skip those
+                for (u32 i = 1; i < numBaseClasses; ++i)
+                {
+                    type_id_t const id = rawType(baseClassList[i].getId());
+                    u16 const       d  = depth(id);
+                    if (d < outDepth && span[outDepth - 1 - d] == id)
+                        continue;
+                    if ((outMask & s_ancestor_bit(id)) != 0 && impl::findAncestor(span + outDepth, count - outDepth, id))
+                        continue;
+
+                    // insertion sort on depth, deepest (nearest) first, keeps the base class order on equal depth
+                    u32 j = count++;
+                    while (j > outDepth && depth(span[j - 1]) < d)
+                    {
+                        span[j] = span[j - 1];
+                        --j;
+                    }
+                    span[j] = id;
+                    outMask |= s_ancestor_bit(id);
+                }
+                return count;
+            }
+
+            // The high half of a name hash picks the bucket, the low half is where the displacement of
+            // the bucket starts and a multiple of the hash is the step of the displacement
+            static inline u32 s_sealed_bucket(u64 hash, u32 bucketCount) { return (u32)(((hash >> 32) * bucketCount) >> 32); }
+
+            static inline u32 s_sealed_slot(u64 hash, u32 displacement, u32 size)
             {
+                u32 const step = (u32)((hash * 0x9E3779B97F4A7C15ULL) >> 32) | 1;
+                return (u32)(((u64)(u32)((u32)hash + displacement * step) * size) >> 32);
+            }
+
+            // The only record of the sealed index that can hold \a hash
+            static inline sealed_record_t const *s_sealed_record(sealed_index_t const *sealed, u64 hash)
+            {
+                u32 const displacement = sealed->m_displacements[s_sealed_bucket(hash, sealed->m_bucketCount)];
+                return &sealed->m_records[s_sealed_slot(hash, displacement, sealed->m_size)];
+            }
+
+            // Lock-free, can run concurrently with a writer inserting a type
+            bool find_type_id(const char *name, u32 length, u64 hash, type_id_t &typeId) const
+            {
+                sealed_index_t const *sealed = sealedIndex.load(std::memory_order_acquire);
+                if (sealed != nullptr)
+                {
+                    sealed_record_t const *record = s_sealed_record(sealed, hash);
+                    if (record->m_hash == hash && record->m_length == length && s_equal_names(name, record->m_name, length))
+                    {
+                        typeId = record->m_id;
+                        return true;
+                    }
+                    if (!sealed->m_stale.load(std::memory_order_acquire))
+                    {
+                        typeId = 0;
+                        return false;
+                    }
+                }
+
+                // linear probing from the home slot of the hash, the index is never full so
+                // every probe sequence ends at an empty slot
+                hash_index_t const *index = hashIndex.load(std::memory_order_acquire);
+                u32 const           mask  = index->m_size - 1;
+                u32                 slot  = (u32)hash & mask;
+                type_id_t           id;
+                while ((id = index->m_slots[slot].m_id.load(std::memory_order_acquire)) != 0)
+                {
+                    if (index->m_slots[slot].m_hash.load(std::memory_order_acquire) == hash)
+                    {
+                        // the id can be of a removed type whose tombstone is being reused, its name can be
+                        // overwritten while it is compared, so the id is checked before and after
+                        if (this->hash(id) != hash)
+                            continue;
+                        bool const equal = nameLength(id) == length && s_equal_names(name, this->name(id), length);
+                        if (this->hash(id) != hash)
+                            continue;
+                        if (equal)
+                        {
+                            typeId = id;
+                            return true;
+                        }
+                    }
+                    slot = (slot + 1) & mask;
+                }
+
+                typeId = 0;
+                return false;
             }
 
-            static type_info_data_t &instance()
+            // Lock-free, the first type whose name hashes to \a hash
+            type_id_t find_stable_id(u64 hash) const
             {
-                static type_info_data_t obj;
-                return obj;
+                if (hash == 0)  // tombstones and unregistered ids
+                    return 0;
+
+                sealed_index_t const *sealed = sealedIndex.load(std::memory_order_acquire);
+                if (sealed != nullptr)
+                {
+                    sealed_record_t const *record = s_sealed_record(sealed, hash);
+                    if (record->m_hash == hash)
+                        return record->m_id;
+                    if (!sealed->m_stale.load(std::memory_order_acquire))
+                        return 0;
+                }
+
+                hash_index_t const *index = hashIndex.load(std::memory_order_acquire);
+                u32 const           mask  = index->m_size - 1;
+                u32                 slot  = (u32)hash & mask;
+                type_id_t           id;
+                while ((id = index->m_slots[slot].m_id.load(std::memory_order_acquire)) != 0)
+                {
+                    if (index->m_slots[slot].m_hash.load(std::memory_order_acquire) == hash)
+                    {
+                        if (this->hash(id) != hash)
+                            continue;  // a tombstone that is being reused, see find_type_id
+                        return id;
+                    }
+                    slot = (slot + 1) & mask;
+                }
+                return 0;
             }
 
-            static u64 s_hash_name(const char *name)
-            {
-                // FNv-1a hash
-                u64 hash = 14695981039346656037ULL;
-                while (*name)
+            // Returns false when a tombstone was reused, true when an empty slot was taken. A tombstone keeps
+            // the id of the removed type, the new id is stored before the new hash, so a reader that pairs
+            // the old id with the new hash sees that the cold hash of that id differs and reads the slot again.
+            static bool s_insert_hash_index(hash_index_t *index, u64 hash, type_id_t typeId)
+            {
+                u32 const mask = index->m_size - 1;
+                u32       slot = (u32)hash & mask;
+                while (index->m_slots[slot].m_id.load(std::memory_order_relaxed) != 0)
+                {
+                    if (index->m_slots[slot].m_hash.load(std::memory_order_relaxed) == 0)
+                    {
+                        index->m_slots[slot].m_id.store(typeId, std::memory_order_relaxed);
+                        index->m_slots[slot].m_hash.store(hash, std::memory_order_release);
+                        return false;
+                    }
+                    slot = (slot + 1) & mask;
+                }
+                index->m_slots[slot].m_hash.store(hash, std::memory_order_relaxed);
+                index->m_slots[slot].m_id.store(typeId, std::memory_order_release);
+                return true;
+            }
+
+            // Makes sure the index can take one more type, rebuilds it at double the size when needed. Like
+            // globalIDCounter the count includes id 0, tombstones count as used until the index is rebuilt.
+            void reserve_hash_index()
+            {
+                hash_index_t *index = hashIndex.load(std::memory_order_relaxed);
+                if ((indexUsed + 2) * 2 <= index->m_size)
+                    return;
+
+                RTTR_STATS_TIME(m_index_rebuild);
+                RTTR_STATS_ADD(m_index_rebuilds, 1);
+
+                u32 const live = globalIDCounter - freeCount;
+                u32       size = index->m_size;
+                while ((live + 1) * 2 > size)
+                    size *= 2;
+
+                hash_index_t *grown = new_hash_index(size, index);
+                indexUsed           = 0;
+                for (u32 id = 1; id < globalIDCounter; ++id)
+                {
+                    if (hash((type_id_t)id) != 0)
+                        indexUsed += s_insert_hash_index(grown, hash((type_id_t)id), (type_id_t)id) ? 1 : 0;
+                }
+                hashIndex.store(grown, std::memory_order_release);
+            }
+
+            // Writers must hold writeLock, the profile slot that reserves an id for \a hash, nullptr when there is none
+            profile_slot_t *take_profile_slot(u64 hash)
+            {
+                if (profilePending == 0 || hash == 0)
+                    return nullptr;
+                u32 const mask = profileSize - 1;
+                for (u32 slot = (u32)hash & mask; profileSlots[slot].m_hash != 0; slot = (slot + 1) & mask)
+                {
+                    if (profileSlots[slot].m_hash == hash)
+                        return profileSlots[slot].m_id != 0 ? &profileSlots[slot] : nullptr;
+                }
+                return nullptr;
+            }
+
+            // Writers must hold writeLock, only an empty registry can load a profile. The reserved ids stay
+            // unregistered (hash 0, raw type 0) until their type is registered, their ancestor spans are
+            // reserved in profile order at the start of the ancestor table.
+            bool load_profile(const type_profile_entry_t *entries, u32 count)
+            {
+                if (globalIDCounter != 1 || profileSlots != nullptr || count == 0 || count >= RTTR_MAX_TYPE_COUNT)
+                    return false;
+
+                u32 size = 16;
+                while (size < count * 2)
+                    size *= 2;
+                profile_slot_t *slots = s_new_array<profile_slot_t>(allocator, size);
+                for (u32 i = 0; i < size; ++i)
+                {
+                    slots[i].m_hash = 0;
+                    slots[i].m_id   = 0;
+                }
+                u32 spans = 0;
+                for (u32 e = 0; e < count; ++e)
+                {
+                    u64 const hash = entries[e].m_stableId;
+                    u32       slot = (u32)hash & (size - 1);
+                    while (slots[slot].m_hash != 0 && slots[slot].m_hash != hash)
+                        slot = (slot + 1) & (size - 1);
+                    if (hash == 0 || slots[slot].m_hash == hash || entries[e].m_ancestors > 0xFFFF)
+                    {
+                        s_delete_array(allocator, slots);
+                        return false;
+                    }
+                    slots[slot].m_hash = hash;
+                    slots[slot].m_id   = (type_id_t)(e + 1);
+                    spans += entries[e].m_ancestors;
+                }
+
+                while (chunkCount * RTTR_TYPE_CHUNK_SIZE < count + 1)
+                    add_chunk();
+                reserve_ancestors(spans);
+                for (u32 e = 0; e < count; ++e)
+                {
+                    type_id_t const id             = (type_id_t)(e + 1);
+                    type_chunk_t   *c              = chunk(id);
+                    u32 const       i              = id & RTTR_TYPE_CHUNK_MASK;
+                    c->nameList[i]                 = "Invalid type_info_t";
+                    c->nameLength[i]               = s_name_length(c->nameList[i]);
+                    c->hashList[i]                 = 0;
+                    c->ancestorCapacity[i]         = (u16)entries[e].m_ancestors;
+                    c->records[i]                  = type_record_t();
+                    c->records[i].m_ancestorOffset = ancestorCount;
+                    ancestorCount += entries[e].m_ancestors;
+                }
+
+                allocatedBytes += size * sizeof(profile_slot_t);
+                profileSlots    = slots;
+                profileSize     = size;
+                profilePending  = count;
+                globalIDCounter = count + 1;
+                return true;
+            }
+
+            // Merge sort from large to small, bottom up, \a scratch has room for \a count keys
+            static void s_sort_descending(u64 *keys, u64 *scratch, u32 count)
+            {
+                for (u32 width = 1; width < count; width *= 2)
+                {
+                    for (u32 start = 0; start < count; start += 2 * width)
+                    {
+                        u32 const middle = (start + width) < count ? (start + width) : count;
+                        u32 const end    = (start + 2 * width) < count ? (start + 2 * width) : count;
+                        u32       a = start, b = middle, o = start;
+                        while (a < middle && b < end)
+                            scratch[o++] = keys[a] >= keys[b] ? keys[a++] : keys[b++];
+                        while (a < middle)
+                            scratch[o++] = keys[a++];
+                        while (b < end)
+                            scratch[o++] = keys[b++];
+                    }
+                    for (u32 i = 0; i < count; ++i)
+                        keys[i] = scratch[i];
+                }
+            }
+
+            // Writers must hold writeLock, counts the uses of every type in \a events and writes the most used
+            // types to \a entries. Ids that are not (or no longer) registered are skipped.
+            u32 make_profile(const trace_event_t *events, u32 eventCount, type_profile_entry_t *entries, u32 capacity) const
+            {
+                u32 const typeCount = globalIDCounter;
+                u32      *uses      = s_new_array<u32>(allocator, typeCount);
+                for (u32 id = 0; id < typeCount; ++id)
+                    uses[id] = 0;
+                for (u32 e = 0; e < eventCount; ++e)
+                {
+                    type_id_t const ids[2] = {events[e].m_source, events[e].m_target};
+                    for (u32 i = 0; i < 2; ++i)
+                    {
+                        if (ids[i] >= typeCount || hash(ids[i]) == 0)
+                            continue;
+                        uses[ids[i]]++;
+                        if (rawType(ids[i]) != ids[i])
+                            uses[rawType(ids[i])]++;
+                    }
+                }
+
+                // most uses first, on equal uses the lower id first so the registration order is kept
+                u64 *keys    = s_new_array<u64>(allocator, typeCount);
+                u64 *scratch = s_new_array<u64>(allocator, typeCount);
+                u32  used    = 0;
+                for (u32 id = 1; id < typeCount; ++id)
+                {
+                    if (uses[id] != 0)
+                        keys[used++] = ((u64)uses[id] << 32) | (u32)~id;
+                }
+                s_sort_descending(keys, scratch, used);
+
+                u32 const count = used < capacity ? used : capacity;
+                for (u32 k = 0; k < count; ++k)
+                {
+                    type_id_t const id     = (type_id_t)~(u32)keys[k];
+                    entries[k].m_stableId  = hash(id);
+                    entries[k].m_ancestors = record(id).m_ancestorCount;
+                    entries[k].m_uses      = uses[id];
+                }
+                s_delete_array(allocator, scratch);
+                s_delete_array(allocator, keys);
+                s_delete_array(allocator, uses);
+                return count;
+            }
+
+            // Writers must hold writeLock, the type is published to readers by the final insert into the name index
+            type_id_t insert_type_id(const char *name, u32 length, u64 hash, const type_info_t &rawTypeInfo, const type_info_t *baseClassList, int numBaseClasses)
+            {
+                // a type of the profile takes the id reserved for it, after that the id of an unregistered
+                // type is reused first, its generation was bumped when it was freed
+                profile_slot_t *const reserved = take_profile_slot(hash);
+                bool const            reused   = reserved == nullptr && freeCount > 0;
+                bool const            appended = reserved == nullptr && !reused;
+                ASSERT(!appended || globalIDCounter < RTTR_MAX_TYPE_COUNT);
+                if (appended && globalIDCounter >= RTTR_MAX_TYPE_COUNT)
+                {
+                    return 0;
+                }
+
+                if (appended && (globalIDCounter & RTTR_TYPE_CHUNK_MASK) == 0)
+                    add_chunk();
+                reserve_hash_index();
+
+                type_id_t const newTypeId = reserved != nullptr ? reserved->m_id : reused ? freeIds[freeCount - 1] : (type_id_t)globalIDCounter;
+                type_chunk_t   *newChunk  = chunk(newTypeId);
+                u32 const       slot      = newTypeId & RTTR_TYPE_CHUNK_MASK;
+                type_record_t  &newRecord = newChunk->records[slot];
+                newChunk->nameList[slot]   = name;
+                newChunk->nameLength[slot] = length;
+                newChunk->hashList[slot]   = hash;
+                newRecord.m_rawType        = ((rawTypeInfo.getId() == 0) ? newTypeId : rawTypeInfo.getId());
+
+                // the span is built at the end of the table, a reused or reserved id moves it into its own span when it fits
+                type_id_t *span           = reserve_ancestors(ancestor_bound(baseClassList, (u32)numBaseClasses));
+                u32 const  count          = build_ancestors(baseClassList, (u32)numBaseClasses, span, newRecord.m_depth, newRecord.m_ancestorMask);
+                newRecord.m_ancestorCount = (u16)count;
+                if (!appended && count <= newChunk->ancestorCapacity[slot])
+                {
+                    type_id_t *old = ancestors.load(std::memory_order_relaxed)->m_ids + newRecord.m_ancestorOffset;
+                    for (u32 i = 0; i < count; ++i)
+                        old[i] = span[i];
+                }
+                else
+                {
+                    newRecord.m_ancestorOffset       = ancestorCount;
+                    newChunk->ancestorCapacity[slot] = (u16)count;
+                    ancestorCount += count;
+                }
+
+                // a different name with the same hash makes the stable id ambiguous, findByStableId keeps
+                // returning the earlier type, it is counted for getRegistryStats
+                if (find_stable_id(newChunk->hashList[slot]) != 0)
+                    stableIdCollisions++;
+
+                // lookups that miss the sealed index have to look at the regular index from now on
+                sealed_index_t *sealed = sealedIndex.load(std::memory_order_relaxed);
+                if (sealed != nullptr)
+                    sealed->m_stale.store(true, std::memory_order_release);
+
+                if (s_insert_hash_index(hashIndex.load(std::memory_order_relaxed), newChunk->hashList[slot], newTypeId))
+                    indexUsed++;
+                if (reserved != nullptr)
+                {
+                    reserved->m_id = 0;
+                    profilePending--;
+                }
+                else if (reused)
+                    freeCount--;
+                else
+                    globalIDCounter++;
+                s_invalidate_cast_caches();
+                return newTypeId;
+            }
+
+            // Writers must hold writeLock, frees the id of a registered type that no other type depends on
+            bool remove_type_id(type_id_t typeId)
+            {
+                // another type that has it as raw type or as ancestor
+                for (u32 id = 1; id < globalIDCounter; ++id)
+                {
+                    if (id == typeId || hash((type_id_t)id) == 0)
+                        continue;
+                    type_id_t const raw = rawType((type_id_t)id);
+                    if (raw == typeId)
+                        return false;
+                    if (raw != id)
+                        continue;
+                    u32              count;
+                    type_id_t const *list = ancestorList(record(raw), count);
+                    if (impl::findAncestor(list, count, typeId))
+                        return false;
+                }
+
+                // the slot becomes a tombstone, probe sequences that pass it must go on
+                hash_index_t *index = hashIndex.load(std::memory_order_relaxed);
+                u32 const     mask  = index->m_size - 1;
+                u32           slot  = (u32)hash(typeId) & mask;
+                while (index->m_slots[slot].m_id.load(std::memory_order_relaxed) != typeId)
+                    slot = (slot + 1) & mask;
+                index->m_slots[slot].m_hash.store(0, std::memory_order_release);
+
+                // records can not be removed from the sealed index, lookups go back to the regular index
+                sealed_index_t *sealed = sealedIndex.load(std::memory_order_relaxed);
+                if (sealed != nullptr)
+                {
+                    sealed->m_retired = sealedRetired;
+                    sealedRetired     = sealed;
+                    sealedTypeCount   = 0;
+                    sealedIndex.store(nullptr, std::memory_order_release);
+                }
+
+                // the last name in the arena is given back, so unloading in reverse order leaves no holes
+                type_chunk_t *c = chunk(typeId);
+                u32 const     i = typeId & RTTR_TYPE_CHUNK_MASK;
+                if (nameBlocks != nullptr && c->nameList[i] + c->nameLength[i] + 1 == nameBlocks->m_data + nameBlocks->m_used)
+                    nameBlocks->m_used -= c->nameLength[i] + 1;
+
+                c->nameList[i]      = "Invalid type_info_t";
+                c->nameLength[i]    = s_name_length(c->nameList[i]);
+                c->hashList[i]                = 0;
+                c->records[i].m_rawType       = 0;
+                c->records[i].m_ancestorCount = 0;
+                c->records[i].m_depth         = 0;
+                c->records[i].m_ancestorMask  = 0;
+                c->records[i].m_generation++;
+
+                if (freeCount == freeCapacity)
                 {
-                    hash ^= *name++;
-                    hash *= 1099511628211ULL;
+                    u32 const  capacity = freeCapacity == 0 ? 64 : freeCapacity * 2;
+                    type_id_t *grown    = s_new_array<type_id_t>(allocator, capacity);
+                    for (u32 f = 0; f < freeCount; ++f)
+                        grown[f] = freeIds[f];
+                    s_delete_array(allocator, freeIds);
+                    freeIds = grown;
+                    allocatedBytes += (capacity - freeCapacity) * sizeof(type_id_t);
+                    freeCapacity = capacity;
                 }
-                return hash;
+                freeIds[freeCount++] = typeId;
+                removedTypes.fetch_add(1, std::memory_order_relaxed);
+                s_invalidate_cast_caches();
+                return true;
             }
 
-            struct name_hash_t
-            {
-                const char *m_name;
-                u64         m_hash;
-            };
-
-            template <typename T>
-            static inline s8 s_compare_values(T a, T b)
+            // Finds the type or takes the lock and inserts it, \a copyName puts the name in the arena instead of keeping the pointer
+            type_id_t register_type_id(const char *name, u32 length, u64 hash, bool copyName, const type_info_t &rawTypeInfo, const type_info_t *baseClassList, int numBaseClasses)
             {
-                if (a < b)
-                    return -1;
-                if (a > b)
-                    return 1;
-                return 0;
-            }
+                RTTR_STATS_TIME(m_registration);
+                RTTR_STATS_ADD(m_registrations, 1);
 
-            static s8 s_compare_names(const char *nameA, const char *nameB)
-            {
-                while (*nameA && *nameB)
+                type_id_t typeId;
+                if (find_type_id(name, length, hash, typeId))
                 {
-                    s8 const result = s_compare_values(*nameA, *nameB);
-                    if (result != 0)
-                        return result;
-                    ++nameA;
-                    ++nameB;
+                    // a snapshot made by a different build can disagree with the types of this one, the
+                    // snapshot wins and the mismatch is counted for getRegistryStats
+                    if (typeId < snapshotTypeCount && !matches_snapshot(typeId, rawTypeInfo, baseClassList, numBaseClasses))
+                        snapshotMismatches.fetch_add(1, std::memory_order_relaxed);
+                    RTTR_TRACE(TRACE_REGISTER, typeId, rawType(typeId), false);
+                    return typeId;
                 }
-                return s_compare_values(*nameA, *nameB);
-            }
 
-            static bool s_less_type_id(const void *_key, const void *_array, u32 _index, const void *_user_data)
-            {
-                type_info_data_t const *type_info_data = (type_info_data_t const *)_user_data;
-                name_hash_t const      *key            = (name_hash_t const *)_key;
-                s16 const               remap          = ((s16 const *)_array)[_index];
-                s8 const                hc             = s_compare_values(key->m_hash, type_info_data->hashList[remap]);
-                if (hc == 0)
+                // another thread may have registered the same name since the lock-free lookup
+                std::lock_guard<std::mutex> lock(writeLock);
+                bool const found = find_type_id(name, length, hash, typeId);
+                if (!found)
                 {
-                    s8 const nc = s_compare_names(key->m_name, type_info_data->nameList[remap]);
-                    return nc == -1;
+                    typeId = insert_type_id(copyName ? intern_name(name, length) : name, length, hash, rawTypeInfo, baseClassList, numBaseClasses);
+                    RTTR_STATS_ADD(m_inserted_types, typeId != 0 ? 1 : 0);
                 }
-                return hc == -1;
+                RTTR_TRACE(TRACE_REGISTER, typeId, rawType(typeId), !found && typeId != 0);
+                return typeId;
             }
 
-            static bool s_equal_type_id(const void *_key, const void *_array, u32 _index, const void *_user_data)
+            // Writers must hold writeLock, builds the sealed index over all registered types and publishes it
+            bool seal()
             {
-                type_info_data_t const *type_info_data = (type_info_data_t const *)_user_data;
-                name_hash_t const      *key            = (name_hash_t const *)_key;
-                s16 const               remap          = ((s16 const *)_array)[_index];
-                s8 const                hc             = s_compare_values(key->m_hash, type_info_data->hashList[remap]);
-                if (hc == 0)
+                // a name hash that is taken twice can not be separated, only the first type gets a record
+                // like find_stable_id, the others are still found through the regular index
+                u32 const  typeCount = globalIDCounter;
+                type_id_t *keys      = s_new_array<type_id_t>(allocator, typeCount);
+                u32        size      = 0;
+                for (u32 id = 1; id < typeCount; ++id)
                 {
-                    s8 const nc = s_compare_names(key->m_name, type_info_data->nameList[remap]);
-                    return nc == 0;
+                    if (find_stable_id(hash((type_id_t)id)) == id)
+                        keys[size++] = (type_id_t)id;
+                }
+                if (size == 0)
+                {
+                    s_delete_array(allocator, keys);
+                    return false;
                 }
-                return false;
-            }
 
-            bool find_type_id(const char *name, type_id_t &typeId) const
-            {
-                // hash the name, then search the hash array through the remap array
-                // using binary search since the remap array is sorted by hash value.
-                u64         hash = s_hash_name(name);
-                name_hash_t key  = {name, hash};
+                // the keys grouped by bucket (counting sort), and the buckets ordered by size, largest first,
+                // so the buckets with most names are placed while the table is still empty
+                u32 const bucketCount = size / RTTR_SEALED_BUCKET_LOAD + 1;
+                u32      *bucketStart = s_new_array<u32>(allocator, bucketCount + 1);
+                u32      *cursor      = s_new_array<u32>(allocator, bucketCount);
+                u32      *bucketKeys  = s_new_array<u32>(allocator, size);
+                u32      *order       = s_new_array<u32>(allocator, bucketCount);
+                u32       sizeCount[66];
+                for (u32 b = 0; b <= bucketCount; ++b)
+                    bucketStart[b] = 0;
+                for (u32 k = 0; k < size; ++k)
+                    bucketStart[s_sealed_bucket(hash(keys[k]), bucketCount) + 1]++;
+                for (u32 b = 0; b < bucketCount; ++b)
+                    bucketStart[b + 1] += bucketStart[b];
+                for (u32 b = 0; b < bucketCount; ++b)
+                    cursor[b] = bucketStart[b];
+                for (u32 k = 0; k < size; ++k)
+                    bucketKeys[cursor[s_sealed_bucket(hash(keys[k]), bucketCount)]++] = k;
 
-                s32 const pos = g_BinarySearch((s16 const *)fullRemap, globalIDCounter, &key, this, s_less_type_id, s_equal_type_id);
-                if (pos >= 0)
+                for (u32 c = 0; c < 66; ++c)
+                    sizeCount[c] = 0;
+                for (u32 b = 0; b < bucketCount; ++b)
+                {
+                    u32 const count = bucketStart[b + 1] - bucketStart[b];
+                    sizeCount[count > 64 ? 0 : 65 - count]++;  // 0 holds the oversized buckets
+                }
+                for (u32 c = 0, start = 0; c < 66; ++c)
+                {
+                    u32 const n  = sizeCount[c];
+                    sizeCount[c] = start;
+                    start += n;
+                }
+                for (u32 b = 0; b < bucketCount; ++b)
                 {
-                    s16 const remap = fullRemap[pos];
-                    typeId          = rawTypeList[remap];
-                    return true;
+                    u32 const count                                = bucketStart[b + 1] - bucketStart[b];
+                    order[sizeCount[count > 64 ? 0 : 65 - count]++] = b;
                 }
 
-                if (globalIDCounter > lastIDCounter)
+                sealed_index_t *sealed  = s_new<sealed_index_t>(allocator);
+                sealed->m_size          = size;
+                sealed->m_bucketCount   = bucketCount;
+                sealed->m_displacements = s_new_array<u32>(allocator, bucketCount);
+                sealed->m_records       = s_new_array<sealed_record_t>(allocator, size);
+                sealed->m_stale.store(false, std::memory_order_relaxed);
+                sealed->m_retired = sealedIndex.load(std::memory_order_relaxed);
+                for (u32 i = 0; i < size; ++i)
+                    sealed->m_records[i].m_id = 0;
+
+                bool sealedAll = true;
+                u32  slots[64];
+                for (u32 o = 0; o < bucketCount && sealedAll; ++o)
                 {
-                    s32 const pos2 = g_BinarySearch((s16 const *)tempRemap, globalIDCounter - lastIDCounter, &key, this, s_less_type_id, s_equal_type_id);
-                    if (pos2 >= 0)
+                    u32 const b     = order[o];
+                    u32 const count = bucketStart[b + 1] - bucketStart[b];
+                    sealed->m_displacements[b] = 0;
+                    if (count == 0)
+                        continue;
+                    if (count > 64)
                     {
-                        s16 const remap = tempRemap[pos2];
-                        typeId          = rawTypeList[remap];
-                        return true;
+                        sealedAll = false;
+                        break;
+                    }
+
+                    // the first displacement that puts every name of the bucket in its own free record
+                    u32 displacement = 0;
+                    for (; displacement < RTTR_SEALED_MAX_DISPLACEMENT; ++displacement)
+                    {
+                        bool fits = true;
+                        for (u32 i = 0; i < count && fits; ++i)
+                        {
+                            slots[i] = s_sealed_slot(hash(keys[bucketKeys[bucketStart[b] + i]]), displacement, size);
+                            fits     = sealed->m_records[slots[i]].m_id == 0;
+                            for (u32 j = 0; j < i && fits; ++j)
+                                fits = slots[j] != slots[i];
+                        }
+                        if (fits)
+                            break;
+                    }
+                    if (displacement == RTTR_SEALED_MAX_DISPLACEMENT)
+                    {
+                        sealedAll = false;
+                        break;
+                    }
+
+                    sealed->m_displacements[b] = displacement;
+                    for (u32 i = 0; i < count; ++i)
+                    {
+                        type_id_t const id                = keys[bucketKeys[bucketStart[b] + i]];
+                        sealed->m_records[slots[i]].m_hash = hash(id);
+                        sealed->m_records[slots[i]].m_name   = name(id);
+                        sealed->m_records[slots[i]].m_length = nameLength(id);
+                        sealed->m_records[slots[i]].m_id   = id;
                     }
                 }
 
-                typeId = 0;
-                return false;
+                s_delete_array(allocator, keys);
+                s_delete_array(allocator, bucketStart);
+                s_delete_array(allocator, cursor);
+                s_delete_array(allocator, bucketKeys);
+                s_delete_array(allocator, order);
+
+                if (!sealedAll)
+                {
+                    s_delete_array(allocator, sealed->m_displacements);
+                    s_delete_array(allocator, sealed->m_records);
+                    s_delete(allocator, sealed);
+                    return false;
+                }
+
+                allocatedBytes += sizeof(sealed_index_t) + bucketCount * sizeof(u32) + size * sizeof(sealed_record_t);
+                sealedTypeCount = size;
+                sealedIndex.store(sealed, std::memory_order_release);
+                return true;
+            }
+
+            static inline u64 s_align8(u64 offset) { return (offset + 7) & ~(u64)7; }
+
+            static void s_snapshot_layout(snapshot_header_t const &header, snapshot_layout_t &layout)
+            {
+                u64 const types          = header.m_typeCount;
+                layout.m_hashes          = s_align8(sizeof(snapshot_header_t));
+                layout.m_rawTypes        = s_align8(layout.m_hashes + types * sizeof(u64));
+                layout.m_ancestorOffsets = s_align8(layout.m_rawTypes + types * sizeof(type_id_t));
+                layout.m_ancestorCounts  = s_align8(layout.m_ancestorOffsets + types * sizeof(u32));
+                layout.m_depths          = s_align8(layout.m_ancestorCounts + types * sizeof(u16));
+                layout.m_masks           = s_align8(layout.m_depths + types * sizeof(u16));
+                layout.m_nameOffsets     = s_align8(layout.m_masks + types * sizeof(u32));
+                layout.m_ancestors       = s_align8(layout.m_nameOffsets + types * sizeof(u32));
+                layout.m_index           = s_align8(layout.m_ancestors + (u64)header.m_ancestorCount * sizeof(type_id_t));
+                layout.m_names           = s_align8(layout.m_index + (u64)header.m_indexSize * sizeof(type_id_t));
+                layout.m_size            = s_align8(layout.m_names + header.m_nameBytes);
+            }
+
+            // Writers must hold writeLock
+            void snapshot_header(snapshot_header_t &header) const
+            {
+                header.m_magic         = RTTR_SNAPSHOT_MAGIC;
+                header.m_version       = RTTR_SNAPSHOT_VERSION;
+                header.m_idSize        = sizeof(type_id_t);
+                header.m_typeCount     = globalIDCounter;
+                header.m_ancestorCount = ancestorCount;
+                header.m_indexSize     = hashIndex.load(std::memory_order_relaxed)->m_size;
+                header.m_nameBytes     = 0;
+                header.m_reserved      = 0;
+                for (u32 id = 1; id < globalIDCounter; ++id)
+                    header.m_nameBytes += nameLength((type_id_t)id) + 1;
             }
 
-            static s8 s_sort_type_info(void const *inItemA, void const *inItemB, void const *inUserData)
+            // Writers must hold writeLock, returns the number of bytes written or 0 when \a size is too small
+            u64 save_snapshot(u8 *image, u64 size) const
             {
-                type_info_data_t *self = (type_info_data_t *)inUserData;
-                s16 const        *a    = (s16 const *)inItemA;
-                s16 const        *b    = (s16 const *)inItemB;
+                snapshot_header_t header;
+                snapshot_layout_t layout;
+                snapshot_header(header);
+                s_snapshot_layout(header, layout);
+                if (size < layout.m_size || freeCount != 0 || profilePending != 0)
+                    return 0;
+
+                for (u64 i = 0; i < layout.m_size; ++i)
+                    image[i] = 0;
+                *(snapshot_header_t *)image = header;
+
+                u32   nameOffset = 0;
+                char *names      = (char *)(image + layout.m_names);
+                for (u32 id = 0; id < globalIDCounter; ++id)
+                {
+                    type_chunk_t const *c = chunk((type_id_t)id);
+                    u32 const           i = id & RTTR_TYPE_CHUNK_MASK;
+                    ((u64 *)(image + layout.m_hashes))[id]          = c->hashList[i];
+                    ((type_id_t *)(image + layout.m_rawTypes))[id]  = c->records[i].m_rawType;
+                    ((u32 *)(image + layout.m_ancestorOffsets))[id] = c->records[i].m_ancestorOffset;
+                    ((u16 *)(image + layout.m_ancestorCounts))[id]  = c->records[i].m_ancestorCount;
+                    ((u16 *)(image + layout.m_depths))[id]          = c->records[i].m_depth;
+                    ((u32 *)(image + layout.m_masks))[id]           = c->records[i].m_ancestorMask;
+                    ((u32 *)(image + layout.m_nameOffsets))[id]     = nameOffset;
+                    if (id == 0)
+                        continue;
+                    const char *n = c->nameList[i];
+                    for (u32 j = 0; j <= c->nameLength[i]; ++j)
+                        names[nameOffset++] = n[j];
+                }
 
-                if (self->hashList[*a] < self->hashList[*b])
-                    return -1;
-                if (self->hashList[*a] > self->hashList[*b])
-                    return 1;
+                type_id_t const *ids = ancestors.load(std::memory_order_relaxed)->m_ids;
+                for (u32 i = 0; i < ancestorCount; ++i)
+                    ((type_id_t *)(image + layout.m_ancestors))[i] = ids[i];
 
-                // compare the names
-                const char *nameA = self->nameList[*a];
-                const char *nameB = self->nameList[*b];
-                return s_compare_names(nameA, nameB);
+                hash_index_t const *index = hashIndex.load(std::memory_order_relaxed);
+                for (u32 i = 0; i < index->m_size; ++i)
+                    ((type_id_t *)(image + layout.m_index))[i] = index->m_slots[i].m_id.load(std::memory_order_relaxed);
+                return layout.m_size;
             }
 
-            type_id_t insert_type_id(const char *name, const type_info_t &rawTypeInfo, const type_info_t *baseClassList, int numBaseClasses)
+            // Checks everything load_snapshot takes from an image before anything is used, an image can be a
+            // truncated or damaged file. The counts are bounded first so the layout can not overflow, then
+            // every id, ancestor span and name has to lie within the image.
+            static bool s_valid_snapshot(u8 const *image, u64 size, snapshot_layout_t &layout)
             {
-                if (globalIDCounter >= RTTR_MAX_TYPE_COUNT)
+                if (size < sizeof(snapshot_header_t) || ((u64)image & 7) != 0)
+                    return false;
+
+                snapshot_header_t const &header = *(snapshot_header_t const *)image;
+                if (header.m_magic != RTTR_SNAPSHOT_MAGIC || header.m_version != RTTR_SNAPSHOT_VERSION || header.m_idSize != sizeof(type_id_t))
+                    return false;
+                u64 const types = header.m_typeCount;
+                if (types < 1 || types > RTTR_MAX_TYPE_COUNT || header.m_indexSize < types * 2 || header.m_indexSize > 4 * (u64)RTTR_MAX_TYPE_COUNT || (header.m_indexSize & (header.m_indexSize - 1)) != 0)
+                    return false;
+                if (header.m_ancestorCount > (types - 1) * 0xFFFF || header.m_ancestorCount > 0x7FFFFFFF)
+                    return false;
+
+                s_snapshot_layout(header, layout);
+                if (size < layout.m_size)
+                    return false;
+
+                u64 const       *hashes          = (u64 const *)(image + layout.m_hashes);
+                type_id_t const *rawTypes        = (type_id_t const *)(image + layout.m_rawTypes);
+                u32 const       *ancestorOffsets = (u32 const *)(image + layout.m_ancestorOffsets);
+                u16 const       *ancestorCounts  = (u16 const *)(image + layout.m_ancestorCounts);
+                u16 const       *depths          = (u16 const *)(image + layout.m_depths);
+                u32 const       *nameOffsets     = (u32 const *)(image + layout.m_nameOffsets);
+                char const      *names           = (char const *)(image + layout.m_names);
+                for (u32 id = 1; id < types; ++id)
                 {
-                    return 0;
+                    if (hashes[id] == 0 || rawTypes[id] == 0 || rawTypes[id] >= types)
+                        return false;
+                    if ((u64)ancestorOffsets[id] + ancestorCounts[id] > header.m_ancestorCount || depths[id] > ancestorCounts[id])
+                        return false;
+
+                    // a name is not empty of bytes, it has at least its terminating zero
+                    u32 const end = (id + 1 < types) ? nameOffsets[id + 1] : header.m_nameBytes;
+                    if (nameOffsets[id] >= end || end > header.m_nameBytes || names[end - 1] != 0)
+                        return false;
+                }
+
+                // the spans of reused ids can have unused entries after their ancestors
+                type_id_t const *ancestors = (type_id_t const *)(image + layout.m_ancestors);
+                for (u32 i = 0; i < header.m_ancestorCount; ++i)
+                {
+                    if (ancestors[i] >= types)
+                        return false;
                 }
 
-                // Is the temporary remap array full? If so, sort it and merge it with the full remap array.
-                if (globalIDCounter - lastIDCounter >= RTTR_TMP_TYPE_COUNT)
+                // every type is in the index once at most, so there are always empty slots to end a probe
+                type_id_t const *index = (type_id_t const *)(image + layout.m_index);
+                u64              used  = 0;
+                for (u32 i = 0; i < header.m_indexSize; ++i)
                 {
-                    // TODO: Sort the range [lastIDCounter, globalIDCounter]
-                    // Merge the [lastIDCounter, globalIDCounter] range with the sorted range which
-                    // is [0, lastIDCounter], this is a lot more optimal than sorting the full range.
-                    g_qsort((s16 *)fullRemap, (s32)globalIDCounter, (s32)sizeof(fullRemap[0]), s_sort_type_info, this);
+                    if (index[i] >= types)
+                        return false;
+                    used += index[i] != 0 ? 1 : 0;
+                }
+                return used < types;
+            }
 
-                    // TODO Sort only the tempRemap and then Merge it with the full remap array
-                    //      This is more optimal than sorting the full remap array.
+            // Writers must hold writeLock, only an empty registry can load a snapshot. The names are
+            // not copied, the image must stay valid for as long as the registry is used.
+            bool load_snapshot(u8 const *image, u64 size)
+            {
+                snapshot_layout_t layout;
+                if (globalIDCounter != 1 || !s_valid_snapshot(image, size, layout))
+                    return false;
+                snapshot_header_t const &header = *(snapshot_header_t const *)image;
 
-                    lastIDCounter = globalIDCounter;
+                while (chunkCount * RTTR_TYPE_CHUNK_SIZE < header.m_typeCount)
+                    add_chunk();
+
+                // the names are stored back to back, the next offset gives the length of a name
+                char const *names       = (char const *)(image + layout.m_names);
+                u32 const  *nameOffsets = (u32 const *)(image + layout.m_nameOffsets);
+                for (u32 id = 1; id < header.m_typeCount; ++id)
+                {
+                    u32 const     end    = (id + 1 < header.m_typeCount) ? nameOffsets[id + 1] : header.m_nameBytes;
+                    type_chunk_t *c      = chunk((type_id_t)id);
+                    u32 const     i      = id & RTTR_TYPE_CHUNK_MASK;
+                    c->nameList[i]       = names + nameOffsets[id];
+                    c->nameLength[i]     = end - nameOffsets[id] - 1;
+                    c->hashList[i]       = ((u64 const *)(image + layout.m_hashes))[id];
+                    c->records[i].m_rawType        = ((type_id_t const *)(image + layout.m_rawTypes))[id];
+                    c->records[i].m_ancestorOffset = ((u32 const *)(image + layout.m_ancestorOffsets))[id];
+                    c->records[i].m_ancestorCount  = ((u16 const *)(image + layout.m_ancestorCounts))[id];
+                    c->records[i].m_depth          = ((u16 const *)(image + layout.m_depths))[id];
+                    c->records[i].m_ancestorMask   = ((u32 const *)(image + layout.m_masks))[id];
                 }
 
-                type_id_t newTypeId                        = globalIDCounter;
-                fullRemap[globalIDCounter]                 = newTypeId;
-                tempRemap[globalIDCounter - lastIDCounter] = newTypeId;
-                nameList[newTypeId]                        = name;
-                hashList[newTypeId]                        = s_hash_name(name);
-                const type_id_t rawId                      = ((rawTypeInfo.getId() == 0) ? newTypeId : rawTypeInfo.getId());
-                rawTypeList[newTypeId]                     = rawId;
-                const int row                              = RTTR_MAX_INHERIT_TYPES_COUNT * rawId;
-                int       index                            = 0;
-                // TODO remove double entries
-                ASSERT(numBaseClasses < RTTR_MAX_INHERIT_TYPES_COUNT);
-                for (int i = 0; i < numBaseClasses; ++i)
+                type_id_t *span = reserve_ancestors(header.m_ancestorCount);
+                for (u32 i = 0; i < header.m_ancestorCount; ++i)
+                    span[i] = ((type_id_t const *)(image + layout.m_ancestors))[i];
+                ancestorCount = header.m_ancestorCount;
+
+                // the slots are taken over as they are, no type has to be hashed or probed
+                hash_index_t *index = hashIndex.load(std::memory_order_relaxed);
+                if (index->m_size != header.m_indexSize)
+                    index = new_hash_index(header.m_indexSize, index);
+                for (u32 i = 0; i < header.m_indexSize; ++i)
                 {
-                    inheritList[row + index] = baseClassList[i].getId();
-                    ++index;
+                    type_id_t const id = ((type_id_t const *)(image + layout.m_index))[i];
+                    if (id == 0)
+                        continue;
+                    index->m_slots[i].m_hash.store(hash(id), std::memory_order_relaxed);
+                    index->m_slots[i].m_id.store(id, std::memory_order_release);
                 }
 
-                globalIDCounter++;
-                return newTypeId;
+                globalIDCounter   = header.m_typeCount;
+                snapshotTypeCount = header.m_typeCount;
+                indexUsed         = header.m_typeCount - 1;
+                hashIndex.store(index, std::memory_order_release);
+                s_invalidate_cast_caches();
+                return true;
+            }
+
+            // Lock-free, checks that a type that was loaded from a snapshot is registered with the same raw type and bases
+            bool matches_snapshot(type_id_t typeId, const type_info_t &rawTypeInfo, const type_info_t *baseClassList, int numBaseClasses) const
+            {
+                type_id_t const rawId = rawTypeInfo.isValid() ? rawTypeInfo.getId() : typeId;
+                if (rawType(typeId) != rawId)
+                    return false;
+
+                u32              count;
+                type_id_t const *list = ancestorList(record(rawId), count);
+                for (int i = 0; i < numBaseClasses; ++i)
+                {
+                    if (!impl::findAncestor(list, count, rawType(baseClassList[i].getId())))
+                        return false;
+                }
+                return true;
             }
 
-            u32         globalIDCounter;
-            u32         lastIDCounter;
-            s16         fullRemap[RTTR_MAX_TYPE_COUNT];  // This map is sorted by the hash value of the name
-            s16         tempRemap[RTTR_TMP_TYPE_COUNT];  // This intermediate map is sorted by the hash value of the name
-            u64         hashList[RTTR_MAX_TYPE_COUNT];
-            const char *nameList[RTTR_MAX_TYPE_COUNT];
-            type_id_t   inheritList[RTTR_MAX_TYPE_COUNT * RTTR_MAX_INHERIT_TYPES_COUNT];
-            type_id_t   rawTypeList[RTTR_MAX_TYPE_COUNT];
+            u32                             globalIDCounter;
+            u32                             chunkCount;
+            u32                             ancestorCount;       // Used entries of the ancestor table
+            u32                             stableIdCollisions;  // Number of types whose stable id was already taken
+            u32                             snapshotTypeCount;   // Ids below this were loaded from a snapshot
+            std::atomic<u32>                snapshotMismatches;  // Registrations that did not match the snapshot
+            u32                             sealedTypeCount;     // Number of types in the sealed index
+            u64                             allocatedBytes;
+            u64                             nameArenaBytes;  // Bytes allocated for the name arena
+            name_block_t                   *nameBlocks;      // The block of the name arena that is being filled
+            u32                             indexUsed;       // Slots of the name index that hold a type or a tombstone
+            u32                             freeCount;       // Ids of unregistered types, reused last freed first
+            u32                             freeCapacity;
+            type_id_t                      *freeIds;
+            std::atomic<u32>                removedTypes;    // Number of types that were ever unregistered
+            u32                             profileSize;     // Slots of profileSlots, a power of two
+            u32                             profilePending;  // Ids reserved by the profile that no type has taken yet
+            profile_slot_t                 *profileSlots;    // Open-addressing map of the profile, stable id to reserved id
+            sealed_index_t                 *sealedRetired;  // Sealed indexes that were dropped by unregistering a type
+            std::atomic<type_chunk_t *>     chunks[RTTR_MAX_CHUNK_COUNT];
+            std::atomic<hash_index_t *>     hashIndex;  // Open-addressing index, maps the hash of a name to the type id
+            std::atomic<ancestor_table_t *> ancestors;  // Ancestor sets of all types
+            std::atomic<sealed_index_t *>   sealedIndex;  // Read-only name index, built by seal()
+
+            std::mutex        writeLock;  // Serialises registration, readers never take it
+            type_info_data_t *previous;   // The registry that was current before this one was pushed
+            alloc_t          *allocator;  // Where all memory of this registry comes from, see setRegistryAllocator
         };
 
         /////////////////////////////////////////////////////////////////////////////////////////
 
         const char *type_info_t::getName() const
         {
-            if (!isValid())
+            type_info_data_t &data = type_info_data_t::instance();
+            if (!data.isRegistered(m_id, m_generation))
                 return "Invalid type_info_t";
+            return data.name(m_id);
+        }
+
+        bool type_info_t::isRegistered() const
+        {
+            type_info_data_t &data = type_info_data_t::instance();
+            return data.isRegistered(m_id, m_generation);
+        }
+
+        /////////////////////////////////////////////////////////////////////////////////////////
+
+        u64 type_info_t::getStableId() const
+        {
             type_info_data_t &data = type_info_data_t::instance();
-            return data.nameList[m_id];
+            if (!data.isRegistered(m_id, m_generation))
+                return 0;
+            return data.hash(m_id);
+        }
+
+        type_info_t type_info_t::find(const char *name, u32 length)
+        {
+            RTTR_STATS_TIME(m_lookup);
+            RTTR_STATS_ADD(m_lookups, 1);
+
+            type_info_data_t &data = type_info_data_t::instance();
+            u64 const         hash = type_info_data_t::s_hash_name(name, length);
+            type_id_t         typeId;
+            if (!data.find_type_id(name, length, hash, typeId))
+                RTTR_STATS_ADD(m_lookup_misses, 1);
+            u16 generation;
+            typeId = data.found(typeId, hash, generation);
+            return type_info_t(typeId, generation);
+        }
+
+        type_info_t type_info_t::findByStableId(u64 stableId)
+        {
+            type_info_data_t &data = type_info_data_t::instance();
+            u16               generation;
+            type_id_t const   typeId = data.found(data.find_stable_id(stableId), stableId, generation);
+            return type_info_t(typeId, generation);
         }
 
         /////////////////////////////////////////////////////////////////////////////////////////
 
         type_info_t type_info_t::getRawType() const
         {
-            if (!isValid())
-                return type_info_t();
             type_info_data_t &data = type_info_data_t::instance();
-            return type_info_t(data.rawTypeList[m_id]);
+            if (!data.isRegistered(m_id, m_generation))
+                return type_info_t();
+            type_id_t const rawId = data.rawType(m_id);
+            return type_info_t(rawId, data.generation(rawId));
         }
 
         /////////////////////////////////////////////////////////////////////////////////////////
 
-        bool type_info_t::isTypeDerivedFrom(const type_info_t &other) const
+        static bool s_is_type_derived_from(type_id_t thisId, type_id_t otherId)
         {
             type_info_data_t &data       = type_info_data_t::instance();
-            const type_id_t   thisRawId  = data.rawTypeList[m_id];
-            const type_id_t   otherRawId = data.rawTypeList[other.m_id];
+            const type_id_t   thisRawId  = data.rawType(thisId);
+            const type_id_t   otherRawId = data.rawType(otherId);
             if (thisRawId == otherRawId)
                 return true;
 
-            const int row = RTTR_MAX_INHERIT_TYPES_COUNT * thisRawId;
-            for (int i = 0; i < RTTR_MAX_INHERIT_TYPES_COUNT; ++i)
+            // O(1) for an ancestor on the primary chain, it can only be at one position
+            type_info_data_t::type_record_t const &thisRaw = data.record(thisRawId);
+            u32                                    count;
+            const type_id_t                       *list       = data.ancestorList(thisRaw, count);
+            u32 const                              thisDepth  = thisRaw.m_depth;
+            u32 const                              otherDepth = data.depth(otherRawId);
+            if (otherDepth < thisDepth && list[thisDepth - 1 - otherDepth] == otherRawId)
+                return true;
+
+            // single inheritance, or multiple inheritance where the mask rules out the other type
+            if (count == thisDepth || (thisRaw.m_ancestorMask & type_info_data_t::s_ancestor_bit(otherRawId)) == 0)
+                return false;
+
+            RTTR_STATS_ADD(m_ancestor_scans, 1);
+            RTTR_STATS_ADD(m_scanned_ancestors, count - thisDepth);
+            return impl::findAncestor(list + thisDepth, count - thisDepth, otherRawId);
+        }
+
+        // Looks in the cast cache of the calling thread first
+        static bool s_is_type_derived_from_cached(type_id_t thisId, type_id_t otherId)
+        {
+            if (thisId == otherId)
+                return true;
+
+#if RTTR_ENABLE_CAST_CACHE
+            cast_cache_t &cache = s_cast_cache;
+            u32 const     epoch = s_cast_cache_epoch.load(std::memory_order_acquire);
+            if (cache.m_epoch != epoch)
             {
-                const type_id_t currId = data.inheritList[row + i];
-                if (currId == otherRawId)
-                    return true;
-                if (currId == 0)  // invalid id
-                    return false;
+                for (u32 i = 0; i < RTTR_CAST_CACHE_SIZE; ++i)
+                    cache.m_keys[i] = 0;
+                cache.m_epoch = epoch;
+            }
+
+            u64 const key  = ((u64)thisId << 32) | otherId;
+            u32 const slot = (u32)((key * 0x9E3779B97F4A7C15ULL) >> 32) & (RTTR_CAST_CACHE_SIZE - 1);
+            u64 const bit  = (u64)1 << slot;
+            if (cache.m_keys[slot] == key)
+            {
+                cache.m_hits++;
+                return (cache.m_results & bit) != 0;
+            }
+
+            cache.m_misses++;
+            bool const result = s_is_type_derived_from(thisId, otherId);
+            cache.m_keys[slot] = key;
+            cache.m_results    = result ? (cache.m_results | bit) : (cache.m_results & ~bit);
+            return result;
+#else
+            return s_is_type_derived_from(thisId, otherId);
+#endif
+        }
+
+        bool type_info_t::isTypeDerivedFrom(const type_info_t &other) const
+        {
+            RTTR_STATS_TIME(m_derived_check);
+            RTTR_STATS_ADD(m_derived_checks, 1);
+
+            // a stale type_info_t is not derived from anything, not even through the type that took over its id
+            type_info_data_t &data   = type_info_data_t::instance();
+            bool const        result = data.isCurrent(m_id, m_generation) && data.isCurrent(other.m_id, other.m_generation) && s_is_type_derived_from_cached(m_id, other.m_id);
+            RTTR_TRACE(TRACE_DERIVED_CHECK, m_id, other.m_id, result);
+            return result;
+        }
+
+        /////////////////////////////////////////////////////////////////////////////////////////
+
+        derived_type_set_t::derived_type_set_t(const type_info_t &target)
+            : m_target(target)
+            , m_count(0)
+            , m_bits(nullptr)
+            , m_allocator(nullptr)
+        {
+            // a registration can fill in a reserved or a freed id below the counter at any time, the
+            // records are only read under the lock
+            type_info_data_t           &data = type_info_data_t::instance();
+            std::lock_guard<std::mutex> lock(data.writeLock);
+            m_count = data.globalIDCounter;
+
+            u32 const words = (m_count + 63) >> 6;
+            m_allocator     = data.allocator;
+            m_bits          = s_new_array<u64>(m_allocator, words * 2);  // zeroed
+
+            // id 0 (the invalid type, and NULL objects) is never in the set
+            if (!target.isRegistered())
+                return;
+            for (u32 id = 1; id < m_count; ++id)
+            {
+                u64 *const word = m_bits + ((id >> 6) << 1);
+                u64 const  bit  = (u64)1 << (id & 63);
+                if (data.rawType((type_id_t)id) == 0)
+                    word[1] |= bit;  // a free or a reserved id, the type that takes it is not known yet
+                else if (s_is_type_derived_from((type_id_t)id, target.getId()))
+                    word[0] |= bit;
             }
-            return false;
         }
 
+        derived_type_set_t::~derived_type_set_t() { s_delete_array(m_allocator, m_bits); }
+
+        bool derived_type_set_t::containsUncovered(type_id_t id) const { return m_target.isRegistered() && s_is_type_derived_from(id, m_target.getId()); }
+
         /////////////////////////////////////////////////////////////////////////////////////////
         /////////////////////////////////////////////////////////////////////////////////////////
         /////////////////////////////////////////////////////////////////////////////////////////
@@ -243,16 +1775,348 @@ namespace ncore
         {
             type_info_t registerOrGetType(const char *name, const type_info_t &rawTypeInfo, const type_info_t *baseClassList, int numBaseClasses)
             {
-                type_info_data_t &data = type_info_data_t::instance();
+                u32 const length = type_info_data_t::s_name_length(name);
+                return registerOrGetType(name, length, type_info_data_t::s_hash_name(name, length), rawTypeInfo, baseClassList, numBaseClasses);
+            }
+
+            type_info_t registerOrGetType(const char *name, u32 length, u64 hash, const type_info_t &rawTypeInfo, const type_info_t *baseClassList, int numBaseClasses)
+            {
+                ASSERT(hash != 0);  // marks free ids and tombstones
+                type_info_data_t &data   = type_info_data_t::instance();
+                type_id_t const   typeId = data.register_type_id(name, length, hash, false, rawTypeInfo, baseClassList, numBaseClasses);
+                return type_info_t(typeId, data.generation(typeId));
+            }
+
+            type_info_t registerOrGetDynamicType(const char *name, u32 length, const type_info_t &rawTypeInfo, const type_info_t *baseClassList, int numBaseClasses)
+            {
+                type_info_data_t &data   = type_info_data_t::instance();
+                type_id_t const   typeId = data.register_type_id(name, length, type_info_data_t::s_hash_name(name, length), true, rawTypeInfo, baseClassList, numBaseClasses);
+                return type_info_t(typeId, data.generation(typeId));
+            }
+
+            type_info_t findType(const char *name) { return type_info_t::find(name, type_info_data_t::s_name_length(name)); }
+
+            void pushRegistry()
+            {
+                type_info_data_t *data = s_new<type_info_data_t>(s_current_allocator());
+                data->previous         = type_info_data_t::current();
+                type_info_data_t::current() = data;
+                s_invalidate_cast_caches();
+            }
+
+            void popRegistry()
+            {
+                type_info_data_t *data = type_info_data_t::current();
+                ASSERT(data->previous != nullptr);
+                if (data->previous == nullptr)
+                    return;
+                type_info_data_t::current() = data->previous;
+                s_delete(data->allocator, data);
+                s_invalidate_cast_caches();
+            }
+        }  // end namespace impl
+
+        /////////////////////////////////////////////////////////////////////////////////////////
+
+        void setRegistryAllocator(alloc_t *allocator) { s_registry_allocator.store(allocator, std::memory_order_release); }
+
+        void getRegistryStats(registry_stats_t &stats)
+        {
+            type_info_data_t           &data = type_info_data_t::instance();
+            std::lock_guard<std::mutex> lock(data.writeLock);
+            stats.m_types                = data.globalIDCounter;
+            stats.m_capacity             = data.chunkCount * RTTR_TYPE_CHUNK_SIZE;
+            stats.m_index_size           = data.hashIndex.load(std::memory_order_relaxed)->m_size;
+            stats.m_ancestors            = data.ancestorCount;
+            stats.m_stable_id_collisions = data.stableIdCollisions;
+            stats.m_snapshot_types       = data.snapshotTypeCount;
+            stats.m_snapshot_mismatches  = data.snapshotMismatches.load(std::memory_order_relaxed);
+            stats.m_sealed_types         = data.sealedTypeCount;
+            stats.m_free_types           = data.freeCount;
+            stats.m_reserved_types       = data.profilePending;
+            stats.m_name_arena_bytes     = data.nameArenaBytes;
+            stats.m_bytes                = data.allocatedBytes;
+        }
+
+        /////////////////////////////////////////////////////////////////////////////////////////
+
+        bool unregisterType(const type_info_t &type)
+        {
+            type_info_data_t           &data = type_info_data_t::instance();
+            std::lock_guard<std::mutex> lock(data.writeLock);
+            if (!type.isRegistered())
+                return false;
+            return data.remove_type_id(type.getId());
+        }
+
+        bool sealRegistry()
+        {
+            type_info_data_t           &data = type_info_data_t::instance();
+            std::lock_guard<std::mutex> lock(data.writeLock);
+            return data.seal();
+        }
+
+        u64 getRegistrySnapshotSize()
+        {
+            type_info_data_t                   &data = type_info_data_t::instance();
+            std::lock_guard<std::mutex>         lock(data.writeLock);
+            type_info_data_t::snapshot_header_t header;
+            type_info_data_t::snapshot_layout_t layout;
+            data.snapshot_header(header);
+            type_info_data_t::s_snapshot_layout(header, layout);
+            return layout.m_size;
+        }
+
+        u64 saveRegistrySnapshot(void *image, u64 size)
+        {
+            type_info_data_t           &data = type_info_data_t::instance();
+            std::lock_guard<std::mutex> lock(data.writeLock);
+            return data.save_snapshot((u8 *)image, size);
+        }
+
+        bool loadRegistrySnapshot(const void *image, u64 size)
+        {
+            type_info_data_t           &data = type_info_data_t::instance();
+            std::lock_guard<std::mutex> lock(data.writeLock);
+            return data.load_snapshot((u8 const *)image, size);
+        }
+
+        u32 makeTypeProfile(const trace_event_t *events, u32 eventCount, type_profile_entry_t *entries, u32 capacity)
+        {
+            type_info_data_t           &data = type_info_data_t::instance();
+            std::lock_guard<std::mutex> lock(data.writeLock);
+            return data.make_profile(events, eventCount, entries, capacity);
+        }
+
+        bool loadTypeProfile(const type_profile_entry_t *entries, u32 count)
+        {
+            type_info_data_t           &data = type_info_data_t::instance();
+            std::lock_guard<std::mutex> lock(data.writeLock);
+            return data.load_profile(entries, count);
+        }
+
+        /////////////////////////////////////////////////////////////////////////////////////////
+
+        void getCastCacheStats(cast_cache_stats_t &stats)
+        {
+#if RTTR_ENABLE_CAST_CACHE
+            stats.m_hits   = s_cast_cache.m_hits;
+            stats.m_misses = s_cast_cache.m_misses;
+#else
+            stats.m_hits   = 0;
+            stats.m_misses = 0;
+#endif
+        }
+
+        void resetCastCacheStats()
+        {
+#if RTTR_ENABLE_CAST_CACHE
+            s_cast_cache.m_hits   = 0;
+            s_cast_cache.m_misses = 0;
+#endif
+        }
+
+        /////////////////////////////////////////////////////////////////////////////////////////
+
+        void getRegistryCounters(registry_counters_t &counters)
+        {
+            u64 *values = (u64 *)&counters;
+#if RTTR_ENABLE_STATS
+            std::lock_guard<std::mutex> lock(s_stats_lock);
+            for (u32 i = 0; i < STATS_COUNTER_COUNT; ++i)
+                values[i] = s_stats_retired[i];
+            for (stats_shard_t *shard = s_stats_shards; shard != nullptr; shard = shard->m_next)
+            {
+                for (u32 i = 0; i < STATS_COUNTER_COUNT; ++i)
+                    values[i] += shard->m_values[i].load(std::memory_order_relaxed);
+            }
+#else
+            for (u32 i = 0; i < sizeof(registry_counters_t) / sizeof(u64); ++i)
+                values[i] = 0;
+#endif
+        }
+
+        void resetRegistryCounters()
+        {
+#if RTTR_ENABLE_STATS
+            std::lock_guard<std::mutex> lock(s_stats_lock);
+            for (u32 i = 0; i < STATS_COUNTER_COUNT; ++i)
+                s_stats_retired[i] = 0;
+            for (stats_shard_t *shard = s_stats_shards; shard != nullptr; shard = shard->m_next)
+            {
+                for (u32 i = 0; i < STATS_COUNTER_COUNT; ++i)
+                    shard->m_values[i].store(0, std::memory_order_relaxed);
+            }
+#endif
+        }
+
+        namespace impl
+        {
+            u64 statsClock() { return s_now_ns(); }
+
+            void statsRecordCast(u64 start, bool succeeded)
+            {
+#if RTTR_ENABLE_STATS
+                RTTR_STATS_ADD(m_casts, 1);
+                RTTR_STATS_ADD(m_failed_casts, succeeded ? 0 : 1);
+                s_stats_time(RTTR_STATS_COUNTER(m_cast), start);
+#else
+                (void)start;
+                (void)succeeded;
+#endif
+            }
+
+            void traceEvent(trace_op_t op, type_id_t source, type_id_t target, bool result)
+            {
+#if RTTR_ENABLE_TRACE
+                trace_ring_t *ring = s_trace_ring.m_ring;
+                if (ring == nullptr)
+                    ring = s_trace_ring.m_ring = s_new_trace_ring();
+
+                u64 const         index = ring->m_end.load(std::memory_order_relaxed);
+                std::atomic<u64> *slot  = ring->m_slots[index & (RTTR_TRACE_BUFFER_SIZE - 1)];
+                ring->m_begin.store(index + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                slot[0].store((s_now_ns() & 0x00FFFFFFFFFFFFFFULL) | ((u64)op << 56) | ((u64)(result ? 1 : 0) << 63), std::memory_order_relaxed);
+                slot[1].store((u64)source | ((u64)target << 32), std::memory_order_relaxed);
+                ring->m_end.store(index + 1, std::memory_order_release);
+#else
+                (void)op;
+                (void)source;
+                (void)target;
+                (void)result;
+#endif
+            }
+        }  // end namespace impl
+
+        /////////////////////////////////////////////////////////////////////////////////////////
+
+        void setTraceEnabled(bool enabled)
+        {
+#if RTTR_ENABLE_TRACE
+            impl::g_traceEnabled.store(enabled, std::memory_order_relaxed);
+#else
+            (void)enabled;
+#endif
+        }
+
+        u32 drainTraceEvents(trace_event_t *events, u32 capacity)
+        {
+            u32 count = 0;
+#if RTTR_ENABLE_TRACE
+            std::lock_guard<std::mutex> lock(s_trace_lock);
+            trace_ring_t              **link = &s_trace_rings;
+            while (*link != nullptr && count < capacity)
+            {
+                trace_ring_t *ring  = *link;
+                u64 const     end   = ring->m_end.load(std::memory_order_acquire);
+                u64           first = ring->m_drained;
+                if (end - first > RTTR_TRACE_BUFFER_SIZE)
+                    first = end - RTTR_TRACE_BUFFER_SIZE;
+                u64 const last = (end - first > capacity - count) ? first + (capacity - count) : end;
+
+                u32 const copied = count;
+                for (u64 i = first; i < last; ++i)
+                {
+                    std::atomic<u64> const *slot  = ring->m_slots[i & (RTTR_TRACE_BUFFER_SIZE - 1)];
+                    u64 const               word0 = slot[0].load(std::memory_order_relaxed);
+                    u64 const               word1 = slot[1].load(std::memory_order_relaxed);
+                    trace_event_t          &event = events[count++];
+                    event.m_time_ns               = word0 & 0x00FFFFFFFFFFFFFFULL;
+                    event.m_op                    = (u8)((word0 >> 56) & 0x7F);
+                    event.m_result                = (u8)(word0 >> 63);
+                    event.m_source                = (type_id_t)word1;
+                    event.m_target                = (type_id_t)(word1 >> 32);
+                    event.m_thread                = ring->m_thread;
+                }
+
+                // the owner kept writing, the events that were copied from overwritten slots are dropped
+                std::atomic_thread_fence(std::memory_order_acquire);
+                u64 const begin = ring->m_begin.load(std::memory_order_relaxed);
+                if (begin > first + RTTR_TRACE_BUFFER_SIZE)
                 {
-                    type_id_t typeId;
-                    if (data.find_type_id(name, typeId))
-                        return type_info_t(typeId);
+                    u64 const torn = begin - RTTR_TRACE_BUFFER_SIZE - first;
+                    u32 const drop = (u32)(torn < last - first ? torn : last - first);
+                    for (u32 i = copied; i + drop < count; ++i)
+                        events[i] = events[i + drop];
+                    count -= drop;
                 }
+                ring->m_drained = last;
 
-                type_id_t newTypeId = data.insert_type_id(name, rawTypeInfo, baseClassList, numBaseClasses);
-                return type_info_t(newTypeId);
+                if (ring->m_retired && last == end)
+                {
+                    *link = ring->m_next;
+                    s_delete(ring->m_allocator, ring);
+                }
+                else
+                {
+                    link = &ring->m_next;
+                }
             }
-        }  // end namespace impl
+#else
+            (void)events;
+            (void)capacity;
+#endif
+            return count;
+        }
+
+        bool drainTraceToFile(const char *path, trace_format_t format)
+        {
+#if RTTR_ENABLE_TRACE
+            FILE *file = fopen(path, format == TRACE_FORMAT_CSV ? "a" : "ab");
+            if (file == nullptr)
+                return false;
+
+            // a file that is drained into again only gets the header once
+            bool written = true;
+            if (ftell(file) == 0)
+            {
+                if (format == TRACE_FORMAT_CSV)
+                {
+                    written = fputs("time_ns,thread,op,source,target,result,source_name,target_name\n", file) >= 0;
+                }
+                else
+                {
+                    trace_file_header_t header;
+                    header.m_magic     = RTTR_TRACE_MAGIC;
+                    header.m_version   = RTTR_TRACE_VERSION;
+                    header.m_eventSize = sizeof(trace_event_t);
+                    header.m_idSize    = sizeof(type_id_t);
+                    written            = fwrite(&header, sizeof(header), 1, file) == 1;
+                }
+            }
+
+            static const char *const ops[] = {"", "register", "derived", "cast"};
+            type_info_data_t        &data  = type_info_data_t::instance();
+            trace_event_t            events[256] = {};
+            u32                      count;
+            while (written && (count = drainTraceEvents(events, 256)) != 0)
+            {
+                if (format != TRACE_FORMAT_CSV)
+                {
+                    written = fwrite(events, sizeof(trace_event_t), count, file) == count;
+                    continue;
+                }
+
+                // the names come from the current registry, an id it does not have gets an empty name
+                u32 typeCount;
+                {
+                    std::lock_guard<std::mutex> lock(data.writeLock);
+                    typeCount = data.globalIDCounter;
+                }
+                for (u32 i = 0; i < count && written; ++i)
+                {
+                    trace_event_t const &e = events[i];
+                    written = fprintf(file, "%llu,%u,%s,%u,%u,%u,\"%s\",\"%s\"\n", (unsigned long long)e.m_time_ns, (u32)e.m_thread, e.m_op <= TRACE_CAST ? ops[e.m_op] : "", (u32)e.m_source, (u32)e.m_target,
+                                      (u32)e.m_result, e.m_source < typeCount ? data.name(e.m_source) : "", e.m_target < typeCount ? data.name(e.m_target) : "") > 0;
+                }
+            }
+            return (fclose(file) == 0) && written;
+#else
+            (void)path;
+            (void)format;
+            return false;
+#endif
+        }
     }  // namespace nrtti
 }  // namespace ncore
@@ -2,8 +2,10 @@
 #define __CRTTR_C_RTTR_H__
 
 #include "crtti/c_type_info.h"
+#include "crtti/c_type_registry.h"
 #include "crtti/c_rttr_enable.h"
 #include "crtti/c_rttr_cast.h"
+#include "crtti/c_rttr_filter.h"
 #include "crtti/c_standard_types.h"
 
 #endif
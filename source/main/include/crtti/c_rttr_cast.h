@@ -11,6 +11,9 @@
  * Returns the given object cast to type T if the object is of type T (or of a subclass); 
  * otherwise returns 0. If object is 0 then it will also return 0.
  *
+ * An upcast or a cast to the same type is resolved at compile time into a static_cast,
+ * only a downcast reads the type_info_t of the object.
+ *
  * \return
  */
 template<typename T, typename Arg>
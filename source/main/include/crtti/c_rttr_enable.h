@@ -5,6 +5,7 @@
 #    pragma once
 #endif
 
+#include "crtti/c_type_info.h"
 #include "crtti/base/c_type_traits.h"
 #include "crtti/base/c_static_assert.h"
 
@@ -14,15 +15,14 @@ namespace ncore
     {
         namespace impl
         {
-            //! A simple typelist_t
-            struct nil
-            {
-            };
-            template <class T, class U = nil>
+            //! A list of types, used for the direct base classes of a class
+            template <class... Ts>
             struct typelist_t
             {
-                typedef T head;
-                typedef U tail;
+                enum
+                {
+                    count = sizeof...(Ts)
+                };
             };
 
             /////////////////////////////////////////////////////////////////////////////////////
@@ -60,59 +60,138 @@ namespace ncore
             };
 
             /*!
-             * This class fills from a given typelist_t the corresponding type_info_t objects into a std::vector.
+             * Checks if \a T is in the given typelist_t.
              */
-            template <class>
-            struct typeinfo_from_baseclass_list_t;
+            template <class T, class List>
+            struct typelist_contains_t;
+
+            template <class T>
+            struct typelist_contains_t<T, typelist_t<>> : Traits::integral_constant<bool, false>
+            {
+            };
+
+            template <class T, class H, class... Ts>
+            struct typelist_contains_t<T, typelist_t<H, Ts...>> : Traits::integral_constant<bool, Traits::is_same<T, H>::value || typelist_contains_t<T, typelist_t<Ts...>>::value>
+            {
+            };
+
+            /*!
+             * Appends the types of the second typelist_t to the first one, skipping the types that are already in it.
+             */
+            template <class List, class Other>
+            struct typelist_merge_t;
+
+            template <class... Ts>
+            struct typelist_merge_t<typelist_t<Ts...>, typelist_t<>>
+            {
+                typedef typelist_t<Ts...> type;
+            };
+
+            template <class... Ts, class H, class... Us>
+            struct typelist_merge_t<typelist_t<Ts...>, typelist_t<H, Us...>>
+            {
+                typedef typename Traits::conditional<typelist_contains_t<H, typelist_t<Ts...>>::value, typelist_t<Ts...>, typelist_t<Ts..., H>>::type head;
+                typedef typename typelist_merge_t<head, typelist_t<Us...>>::type                                                                type;
+            };
+
+            /*!
+             * Flattens a list of direct base classes into the list of all ancestors, at compile time.
+             *
+             * Every base class is followed by its own ancestors, so the first entry is the first
+             * direct base class and the chain of first base classes comes next. An ancestor that
+             * is reached along more than one path (diamond) is only listed once.
+             */
+            template <class List>
+            struct flatten_baseclass_list_t;
 
             template <>
-            struct typeinfo_from_baseclass_list_t<typelist_t<nil>>
+            struct flatten_baseclass_list_t<typelist_t<>>
             {
-                static RTTR_INLINE void fill(type_info_t* outArray, int& i, int maximum) {}
+                typedef typelist_t<> type;
             };
 
-            template <class T, class U>
-            struct typeinfo_from_baseclass_list_t<typelist_t<T, U>>
+            template <class T, class... Ts>
+            struct flatten_baseclass_list_t<typelist_t<T, Ts...>>
             {
-                static RTTR_INLINE void fill(type_info_t* outArray, int& i, int maximum)
-                {
-                    RTTR_STATIC_ASSERT(has_base_class_list<T>::value, PARENT_CLASS_HAS_NO_BASE_CLASS_LIST_DEFINIED__USE_RTTR_ENABLE);
-                    outArray[i++] = metatype_info_t<T>::getTypeInfo();
+                static_assert(has_base_class_list<T>::value, "PARENT_CLASS_HAS_NO_BASE_CLASS_LIST_DEFINIED__USE_RTTR_ENABLE");
+
+                typedef typename typelist_merge_t<typelist_t<T>, typename flatten_baseclass_list_t<typename T::baseClassList>::type>::type first;
+                typedef typename typelist_merge_t<first, typename flatten_baseclass_list_t<typelist_t<Ts...>>::type>::type                 type;
+            };
 
-                    // retrieve also the type_info_t of all base class of the base classes
-                    typeinfo_from_baseclass_list_t<typename T::baseClassList>::fill(outArray, i, maximum);
-                    typeinfo_from_baseclass_list_t<U>::fill(outArray, i, maximum);
+            /*!
+             * Registers a type with the given list of ancestors, the type_info_t of every ancestor
+             * is written into an array of exactly the right size.
+             */
+            template <class List>
+            struct register_with_baseclass_list_t;
+
+            template <>
+            struct register_with_baseclass_list_t<typelist_t<>>
+            {
+                static RTTR_INLINE type_info_t registerType(const char* name, u32 length, u64 hash, const type_info_t& rawTypeInfo) { return registerOrGetType(name, length, hash, rawTypeInfo, nullptr, 0); }
+            };
+
+            template <class... Ts>
+            struct register_with_baseclass_list_t<typelist_t<Ts...>>
+            {
+                static RTTR_INLINE type_info_t registerType(const char* name, u32 length, u64 hash, const type_info_t& rawTypeInfo)
+                {
+                    type_info_t const baseClassList[] = {metatype_info_t<Ts>::getTypeInfo()...};
+                    return registerOrGetType(name, length, hash, rawTypeInfo, baseClassList, (int)sizeof...(Ts));
                 }
             };
 
             /*!
-             * This helper trait returns a vector with type_info_t object of all base classes.
-             * When there is no typelist_t defined or the class has no base class, an empty vector is returned.
+             * This helper trait gives the flattened list of all base classes of \a T.
+             * When there is no typelist_t defined or the class has no base class, the list is empty.
              */
-            template <class T>
+            template <class T, bool = has_base_class_list<T>::value>
             struct base_classes
             {
-            private:
-                // extract the info
-                static RTTR_INLINE void retrieve_impl(type_info_t* outArray, int& i, int maximum, Traits::true_type) { typeinfo_from_baseclass_list_t<typename T::baseClassList>::fill(outArray, i, maximum); }
-
-                // no type list defined
-                static RTTR_INLINE void retrieve_impl(type_info_t* outArray, int& i, int maximum, Traits::false_type) {}
+                typedef typelist_t<> type;
+                enum
+                {
+                    count = 0
+                };
+            };
 
-            public:
-                static RTTR_INLINE void retrieve(type_info_t* outArray, int& i, int maximum) { retrieve_impl(outArray, i, maximum, typename has_base_class_list<T>::type()); }
+            template <class T>
+            struct base_classes<T, true>
+            {
+                typedef typename flatten_baseclass_list_t<typename T::baseClassList>::type type;
+                enum
+                {
+                    count = type::count
+                };
             };
 
+            /*!
+             * \brief Registers \a T under \a name together with all its base classes.
+             *
+             * \remark This is only called once per type, from the static initializer inside
+             *         metatype_info_t<T>::getTypeInfo(). The list of base classes, the length and
+             *         the hash of the name are computed at compile time, only the type_info_t of
+             *         each base class is read here.
+             *
+             * \return A valid type_info_t object.
+             */
+            template <class T>
+            type_info_t registerMetaType(const char* name, u32 length, u64 hash)
+            {
+                return register_with_baseclass_list_t<typename base_classes<T>::type>::registerType(name, length, hash, raw_type_info_t<T>::get());
+            }
+
         }  // end namespace impl
     }  // end namespace nrtti
 }  // namespace ncore
 
-#define TYPE_LIST()                ncore::nrtti::impl::typelist_t<ncore::nrtti::impl::nil>
-#define TYPE_LIST_1(A)             ncore::nrtti::impl::typelist_t<A, TYPE_LIST()>
-#define TYPE_LIST_2(A, B)          ncore::nrtti::impl::typelist_t<A, TYPE_LIST_1(B)>
-#define TYPE_LIST_3(A, B, C)       ncore::nrtti::impl::typelist_t<A, TYPE_LIST_2(B, C)>
-#define TYPE_LIST_4(A, B, C, D)    ncore::nrtti::impl::typelist_t<A, TYPE_LIST_3(B, C, D)>
-#define TYPE_LIST_5(A, B, C, D, E) ncore::nrtti::impl::typelist_t<A, TYPE_LIST_4(B, C, D, E)>
+#define TYPE_LIST(...)             ncore::nrtti::impl::typelist_t<__VA_ARGS__>
+#define TYPE_LIST_1(A)             TYPE_LIST(A)
+#define TYPE_LIST_2(A, B)          TYPE_LIST(A, B)
+#define TYPE_LIST_3(A, B, C)       TYPE_LIST(A, B, C)
+#define TYPE_LIST_4(A, B, C, D)    TYPE_LIST(A, B, C, D)
+#define TYPE_LIST_5(A, B, C, D, E) TYPE_LIST(A, B, C, D, E)
 
 #define RTTR_ENABLE()                                                                                            \
 public:                                                                                                          \
@@ -121,39 +200,17 @@ public:
                                                                                                                  \
 private:
 
-#define RTTR_ENABLE_DERIVED_FROM(A)                                                                              \
+// Takes any number of direct base classes
+#define RTTR_ENABLE_DERIVED_FROM(...)                                                                            \
 public:                                                                                                          \
     virtual RTTR_INLINE ncore::nrtti::type_info_t getTypeInfo() const { return ncore::nrtti::impl::getTypeInfoFromInstance(this); } \
-    typedef TYPE_LIST_1(A) baseClassList;                                                                        \
+    typedef TYPE_LIST(__VA_ARGS__) baseClassList;                                                                \
                                                                                                                  \
 private:
 
-#define RTTR_ENABLE_DERIVED_FROM_2(A, B)                                                                         \
-public:                                                                                                          \
-    virtual RTTR_INLINE ncore::nrtti::type_info_t getTypeInfo() const { return ncore::nrtti::impl::getTypeInfoFromInstance(this); } \
-    typedef TYPE_LIST_2(A, B) baseClassList;                                                                     \
-                                                                                                                 \
-private:
-
-#define RTTR_ENABLE_DERIVED_FROM_3(A, B, C)                                                                      \
-public:                                                                                                          \
-    virtual RTTR_INLINE ncore::nrtti::type_info_t getTypeInfo() const { return ncore::nrtti::impl::getTypeInfoFromInstance(this); } \
-    typedef TYPE_LIST_3(A, B, C) baseClassList;                                                                  \
-                                                                                                                 \
-private:
-
-#define RTTR_ENABLE_DERIVED_FROM_4(A, B, C, D)                                                                   \
-public:                                                                                                          \
-    virtual RTTR_INLINE ncore::nrtti::type_info_t getTypeInfo() const { return ncore::nrtti::impl::getTypeInfoFromInstance(this); } \
-    typedef TYPE_LIST_4(A, B, C, D) baseClassList;                                                               \
-                                                                                                                 \
-private:
-
-#define RTTR_ENABLE_DERIVED_FROM_5(A, B, C, D, E)                                                                \
-public:                                                                                                          \
-    virtual RTTR_INLINE ncore::nrtti::type_info_t getTypeInfo() const { return ncore::nrtti::impl::getTypeInfoFromInstance(this); } \
-    typedef TYPE_LIST_5(A, B, C, D, E) baseClassList;                                                            \
-                                                                                                                 \
-private:
+#define RTTR_ENABLE_DERIVED_FROM_2(A, B)          RTTR_ENABLE_DERIVED_FROM(A, B)
+#define RTTR_ENABLE_DERIVED_FROM_3(A, B, C)       RTTR_ENABLE_DERIVED_FROM(A, B, C)
+#define RTTR_ENABLE_DERIVED_FROM_4(A, B, C, D)    RTTR_ENABLE_DERIVED_FROM(A, B, C, D)
+#define RTTR_ENABLE_DERIVED_FROM_5(A, B, C, D, E) RTTR_ENABLE_DERIVED_FROM(A, B, C, D, E)
 
 #endif  // __RTTR_RTTRENABLE_H__
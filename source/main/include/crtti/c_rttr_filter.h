@@ -0,0 +1,89 @@
+#ifndef __CRTTR_C_RTTR_FILTER_H__
+#define __CRTTR_C_RTTR_FILTER_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "crtti/c_type_info.h"
+
+namespace ncore
+{
+    class alloc_t;
+
+    namespace nrtti
+    {
+        /*!
+         * The set of all types that are derived from a \a target type, as one bit per type id.
+         *
+         * Building the set looks at every registered type once, so build it once and use it for
+         * many rttr_filter calls. Types that are registered after the set was built are not in
+         * the bitset, nor are types that take an id that was free or reserved by a profile while
+         * the set was built. For those the set falls back to type_info_t::isTypeDerivedFrom.
+         */
+        class RTTR_API derived_type_set_t
+        {
+        public:
+            explicit derived_type_set_t(const type_info_t &target);
+            ~derived_type_set_t();
+
+            /*!
+             * \brief Returns the type this set was built for.
+             */
+            type_info_t getTarget() const;
+
+            /*!
+             * \brief Returns the number of type ids that are covered by the bitset.
+             */
+            u32 getCount() const;
+
+            /*!
+             * \brief Returns true if the type with the given \a id is derived from (or is) the target type.
+             */
+            bool contains(type_id_t id) const;
+
+        private:
+            derived_type_set_t(const derived_type_set_t &);
+            derived_type_set_t &operator=(const derived_type_set_t &);
+
+            bool containsUncovered(type_id_t id) const;
+
+            type_info_t m_target;
+            u32         m_count;
+            u64        *m_bits;       // Two words per 64 ids, the derived types and the ids that were not taken
+            alloc_t    *m_allocator;  // The allocator of the registry the set was built for
+        };
+
+    }  // end namespace nrtti
+}  // namespace ncore
+
+/*!
+ * \brief Casts all \a count pointers in \a objects to type \a T and writes the ones for which
+ *        the cast succeeds to \a out, in their original order.
+ *
+ * The type of each object is read once and looked up in \a set, which must be built for the
+ * type \a T points to. \a out must have room for \a count pointers.
+ *
+ * \return The number of pointers written to \a out.
+ */
+template <typename T, typename Arg>
+ncore::u32 rttr_filter(const ncore::nrtti::derived_type_set_t &set, Arg const *objects, ncore::u32 count, T *out);
+
+/*!
+ * \brief Same as above, the derived_type_set_t is built for this call only.
+ */
+template <typename T, typename Arg>
+ncore::u32 rttr_filter(Arg const *objects, ncore::u32 count, T *out);
+
+/*!
+ * \brief Sets bit i of \a outMask when the object at index i of \a objects is of a type in \a set.
+ *
+ * \a outMask must have room for (count + 63) / 64 words, the unused bits of the last word are cleared.
+ * A NULL pointer never matches.
+ */
+template <typename Arg>
+void rttr_filter_mask(const ncore::nrtti::derived_type_set_t &set, Arg const *objects, ncore::u32 count, ncore::u64 *outMask);
+
+#include "crtti/impl/c_rttr_filter_impl.h"
+
+#endif  // __CRTTR_C_RTTR_FILTER_H__
@@ -8,11 +8,22 @@
 #include "crtti/base/c_core_prerequisites.h"
 #include "crtti/base/c_type_traits.h"
 
+// Width of a type id in bits, 16 (at most 65535 types) or 32 (for more types, at 4 more bytes per type)
+#ifndef RTTR_TYPE_ID_BITS
+#    define RTTR_TYPE_ID_BITS 16
+#endif
+
 namespace ncore
 {
     namespace nrtti
     {
+#if RTTR_TYPE_ID_BITS == 16
         typedef u16 type_id_t;
+#elif RTTR_TYPE_ID_BITS == 32
+        typedef u32 type_id_t;
+#else
+#    error "RTTR_TYPE_ID_BITS must be 16 or 32"
+#endif
         class type_info_t;
 
         namespace impl
@@ -22,11 +33,80 @@ namespace ncore
              *
              * \remark When a type with the given name is already registered,
              *         then the type_info_t for the already registered type will be returned.
+             *         Registration is thread-safe, concurrent registrations are serialised while
+             *         lookups and the type_info_t queries stay lock-free.
+             *         Only the pointer to \a name is kept, it has to stay valid for as long as the
+             *         registry is used (like the literals of the macros), see registerOrGetDynamicType.
              *
              * \return A valid type_info_t object.
              */
             RTTR_API type_info_t registerOrGetType(const char *name, const type_info_t &rawTypeInfo, type_info_t const *info, int numBaseClasses);
 
+            /*!
+             * \brief Register the type info for the given name, of which the length and hash are already known
+             *
+             * \remark \a hash becomes the stable id of the type. The macros pass stableIdOf(name, length),
+             *         computed at compile time, so registration does not have to read the name before it
+             *         finds or inserts the type. With any other hash the type is not found by name.
+             *
+             * \return A valid type_info_t object.
+             */
+            RTTR_API type_info_t registerOrGetType(const char *name, u32 length, u64 hash, const type_info_t &rawTypeInfo, type_info_t const *info, int numBaseClasses);
+
+            /*!
+             * \brief Register the type info for a name that is built at runtime, e.g. by a plugin or from data
+             *
+             * \remark Unlike registerOrGetType, which keeps a pointer to \a name, the first \a length
+             *         characters of \a name are copied into memory owned by the registry, so \a name
+             *         does not have to be terminated and only has to be valid during the call.
+             *         When the type is already registered nothing is copied.
+             *
+             * \return A valid type_info_t object.
+             */
+            RTTR_API type_info_t registerOrGetDynamicType(const char *name, u32 length, const type_info_t &rawTypeInfo, type_info_t const *info, int numBaseClasses);
+
+            /*!
+             * \brief Returns the type_info_t that was registered under \a name.
+             *
+             * \return The registered type_info_t, or an invalid type_info_t when there is no type with that name.
+             */
+            RTTR_API type_info_t findType(const char *name);
+
+            // The name hash reads a name 8 bytes at a time as little-endian words, the length is part of
+            // the seed so the zero padding of the last word can not make two names equal
+            constexpr u32 nameLength(const char *name, u32 length = 0) { return name[length] ? nameLength(name, length + 1) : length; }
+            constexpr u64 nameWord(const char *name, u32 bytes) { return bytes == 0 ? 0 : ((nameWord(name + 1, bytes - 1) << 8) | (u64)(u8)name[0]); }
+            constexpr u64 nameHashShift(u64 hash, u32 shift) { return hash ^ (hash >> shift); }
+            constexpr u64 nameHashWords(const char *name, u32 length, u64 hash) { return length >= 8 ? nameHashWords(name + 8, length - 8, nameHashShift((hash ^ nameWord(name, 8)) * 0x9E3779B97F4A7C15ULL, 29)) : (length > 0 ? nameHashShift((hash ^ nameWord(name, length)) * 0x9E3779B97F4A7C15ULL, 29) : hash); }
+
+            /*!
+             * \brief Computes the stable id for the first \a length characters of a type \a name, at compile time when \a name is a literal.
+             */
+            constexpr u64 stableIdOf(const char *name, u32 length)
+            {
+                return nameHashShift(nameHashShift(nameHashShift(nameHashWords(name, length, 14695981039346656037ULL ^ ((u64)length * 0x9E3779B97F4A7C15ULL)), 31) * 0xBF58476D1CE4E5B9ULL, 29) * 0x94D049BB133111EBULL, 32);
+            }
+
+            /*!
+             * \brief Computes the stable id for a type \a name, at compile time when \a name is a literal.
+             */
+            constexpr u64 stableIdOf(const char *name) { return stableIdOf(name, nameLength(name)); }
+
+            /*!
+             * \brief Makes a new and empty registry the current one, until the matching popRegistry().
+             *
+             * \remark Only meant for tests and benchmarks that need a fresh registry, e.g. to measure
+             *         startup registration. Any type_info_t obtained before the push belongs to the
+             *         previous registry and must not be used until the registry is popped again.
+             *         Push and pop are not thread-safe, no other thread may use crtti meanwhile.
+             */
+            RTTR_API void pushRegistry();
+
+            /*!
+             * \brief Destroys the current registry and restores the one that was current before pushRegistry().
+             */
+            RTTR_API void popRegistry();
+
             template <typename T, bool>
             struct raw_type_info_t;
         }  // end namespace impl
@@ -157,11 +237,24 @@ namespace ncore
              *
              * \note This id is unique at process runtime,
              *       but the id can be changed every time the process is executed.
+             *       Use getStableId() for an id that can be stored or sent to another process.
              *
              * \return The type_info_t id.
              */
             type_id_t getId() const;
 
+            /*!
+             * \brief Returns the stable id of this type.
+             *
+             * \note Unlike getId(), this id does not depend on the order in which types are registered,
+             *       it is a 64-bit hash of the registered name. The same name gives the same stable id in
+             *       every process, so it can be stored in files or sent to other processes.
+             *       RTTR_STABLE_ID(T) gives the same value at compile time.
+             *
+             * \return The stable id, 0 for an invalid type_info_t.
+             */
+            u64 getStableId() const;
+
             /*!
              * \brief Returns the unique and human-readable name of the type.
              *
@@ -172,10 +265,25 @@ namespace ncore
             /*!
              * \brief Returns true if this type_info_t is valid, that means the type_info_t holds valid data to a type.
              *
+             * \remark A type_info_t stays valid when its type is unregistered, use isRegistered() to find out
+             *         whether it still refers to a registered type.
+             *
              * \return True if this type_info_t is valid, otherwise false.
              */
             bool isValid() const;
 
+            /*!
+             * \brief Returns true if the type of this type_info_t is still registered.
+             *
+             * \remark When a type is unregistered (see unregisterType) its id can be given to a new type,
+             *         every reuse of an id has a new generation. A type_info_t that was obtained before the
+             *         type was unregistered is stale: it is not equal to the type_info_t of the new type and
+             *         this returns false for it. Generations wrap after 65536 reuses of the same id.
+             *
+             * \return True if this type_info_t refers to a registered type, otherwise false.
+             */
+            bool isRegistered() const;
+
             /*!
              * \brief Returns true if this type_info_t is derived from the given type \a T, otherwise false.
              *
@@ -184,6 +292,17 @@ namespace ncore
             template <typename T>
             bool isTypeDerivedFrom() const;
 
+            /*!
+             * \brief Returns true if this type_info_t is derived from the given type_info_t \a other, otherwise false.
+             *
+             * \remark The result is remembered in a small per thread cache, see cast_cache_stats_t.
+             *         A type_info_t of an unregistered type (see isRegistered) is not derived from
+             *         any type, and no type is derived from it.
+             *
+             * \return Returns true if this type_info_t is a derived type from \a other, otherwise false.
+             */
+            bool isTypeDerivedFrom(const type_info_t &other) const;
+
             /*!
              * \brief Returns a type_info_t object which represent the raw type.
              *
@@ -195,6 +314,26 @@ namespace ncore
              */
             type_info_t getRawType() const;
 
+            /*!
+             * \brief Returns the registered type whose name is the first \a length characters of \a name.
+             *
+             * \remark \a name does not have to be terminated, so names can be looked up straight from a
+             *         file or a network buffer. Lock-free, like all the other queries.
+             *
+             * \return The type_info_t of the type, or an invalid type_info_t when no such type is registered.
+             */
+            static type_info_t find(const char *name, u32 length);
+
+            /*!
+             * \brief Returns the registered type with the given stable id.
+             *
+             * \remark Two names with the same stable id are reported when the second one is registered,
+             *         see registry_stats_t::m_stable_id_collisions, this returns the first of them.
+             *
+             * \return The type_info_t of the type, or an invalid type_info_t when no such type is registered.
+             */
+            static type_info_t findByStableId(u64 stableId);
+
             template <typename T>
             static type_info_t get();
 
@@ -229,22 +368,22 @@ namespace ncore
              * \brief Constructs a valid type_info_t object.
              *
              * \param id The unique id of the data type.
+             * \param generation The number of times \a id was reused.
              */
-            type_info_t(type_id_t id);
+            type_info_t(type_id_t id, u16 generation);
 
-            /*!
-             * \brief Returns true if this type_info_t is derived from the given type_info_t \a other, otherwise false.
-             *
-             * \return Returns true if this type_info_t is a derived type from \a other, otherwise false.
-             */
-            bool isTypeDerivedFrom(const type_info_t &other) const;
+            u64 getKey() const;
 
             RTTR_API friend type_info_t impl::registerOrGetType(const char *name, const type_info_t &rawTypeInfo, type_info_t const *info, int numBaseClasses);
+            RTTR_API friend type_info_t impl::registerOrGetType(const char *name, u32 length, u64 hash, const type_info_t &rawTypeInfo, type_info_t const *info, int numBaseClasses);
+            RTTR_API friend type_info_t impl::registerOrGetDynamicType(const char *name, u32 length, const type_info_t &rawTypeInfo, type_info_t const *info, int numBaseClasses);
+            RTTR_API friend type_info_t impl::findType(const char *name);
             template <typename T, bool>
             friend struct impl::raw_type_info_t;
 
         private:
             type_id_t m_id;
+            u16       m_generation;
         };
 
 #ifdef DOXYGEN
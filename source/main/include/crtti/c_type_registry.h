@@ -0,0 +1,365 @@
+#ifndef __CRTTR_C_TYPE_REGISTRY_H__
+#define __CRTTR_C_TYPE_REGISTRY_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "crtti/base/c_core_prerequisites.h"
+#include "crtti/c_type_info.h"
+
+// Per thread cache of isTypeDerivedFrom results, set to 0 to compile it out
+#ifndef RTTR_ENABLE_CAST_CACHE
+#    define RTTR_ENABLE_CAST_CACHE 1
+#endif
+
+// Number of entries of the cast cache, a power of two no larger than 64
+#ifndef RTTR_CAST_CACHE_SIZE
+#    define RTTR_CAST_CACHE_SIZE 64
+#endif
+
+// Per thread counters and timings of registration, lookups and casts, off by default, see getRegistryCounters
+#ifndef RTTR_ENABLE_STATS
+#    define RTTR_ENABLE_STATS 0
+#endif
+
+// Number of buckets of a timing histogram, bucket i counts the calls that took [2^i, 2^(i+1)) nanoseconds
+#define RTTR_STATS_HISTOGRAM_SIZE 32
+
+// Per thread ring buffers of registration and cast events, compiled in but off until setTraceEnabled(true)
+#ifndef RTTR_ENABLE_TRACE
+#    define RTTR_ENABLE_TRACE 0
+#endif
+
+// Number of events in the ring buffer of a thread, a power of two, the oldest events are overwritten
+#ifndef RTTR_TRACE_BUFFER_SIZE
+#    define RTTR_TRACE_BUFFER_SIZE 4096
+#endif
+
+#if RTTR_ENABLE_TRACE
+#    include <atomic>
+#endif
+
+namespace ncore
+{
+    class alloc_t;
+
+    namespace nrtti
+    {
+        /*!
+         * \brief Sets the allocator for registries that are made from now on, NULL selects the system heap.
+         *
+         * All memory of a registry comes from the allocator it was made with: the chunks, the name
+         * indexes, the ancestor table, the name arena and temporary buffers, and the bitsets of the
+         * derived_type_set_t objects built for it. Trace buffers take the allocator that is set when a
+         * thread records its first event.
+         *
+         * \remark The default registry is made when the first type is registered, so its allocator is
+         *         set from the first static initializer. A registry of impl::pushRegistry() gets the
+         *         allocator that is set at that time. The allocator has to outlive the registry.
+         */
+        RTTR_API void setRegistryAllocator(alloc_t *allocator);
+
+        /*!
+         * This structure reports the memory use of the type registry.
+         *
+         * The registry starts small and grows in chunks of types, a chunk is never moved
+         * once allocated, so type ids stay valid while the registry grows.
+         */
+        struct registry_stats_t
+        {
+            u32 m_types;                 //!< Number of used entries, including the invalid type (id 0) and the free ids
+            u32 m_capacity;              //!< Number of entries that fit in the currently allocated chunks
+            u32 m_index_size;            //!< Number of slots in the name index
+            u32 m_ancestors;             //!< Number of used entries in the ancestor table
+            u32 m_stable_id_collisions;  //!< Number of types that got the stable id of an earlier type
+            u32 m_snapshot_types;        //!< Number of entries that were loaded from a snapshot, including id 0
+            u32 m_snapshot_mismatches;   //!< Number of registrations that did not match the loaded snapshot
+            u32 m_sealed_types;          //!< Number of types in the index built by the last sealRegistry()
+            u32 m_free_types;            //!< Number of ids of unregistered types that wait to be reused
+            u32 m_reserved_types;        //!< Number of ids reserved by loadTypeProfile whose type is not registered yet
+            u64 m_name_arena_bytes;      //!< Number of bytes allocated for names that were copied into the registry
+            u64 m_bytes;                 //!< Number of bytes allocated by the registry, including the name arena
+        };
+
+        /*!
+         * \brief Fills \a stats with the current capacity, number of used entries and bytes of the type registry.
+         */
+        RTTR_API void getRegistryStats(registry_stats_t &stats);
+
+        /*!
+         * \brief Removes \a type from the registry, so the module that declared it can be unloaded.
+         *
+         * The name is removed from the name index and the stable id lookup, the id and the ancestor
+         * span are reused by a later registration. The id gets a new generation on reuse, so a
+         * type_info_t of the removed type is detected by type_info_t::isRegistered().
+         *
+         * \remark A type can only be removed when no other registered type derives from it or has
+         *         it as raw type, so the types of a module are removed derived types (and pointer
+         *         variants) first. No other thread may use or look up the removed type meanwhile,
+         *         lookups of other types can run concurrently. A derived_type_set_t made while the
+         *         type was registered has to be made again. Removing a type also drops the index built
+         *         by sealRegistry().
+         *
+         * \return False when \a type is not registered (invalid or stale) or other types depend on it.
+         */
+        RTTR_API bool unregisterType(const type_info_t &type);
+
+        /*!
+         * \brief Builds a read-only name index over all registered types, for when the set of types is complete.
+         *
+         * The index is a minimal perfect hash: a name is found with one hash, one displacement and one
+         * record read, or rejected without probing. Registration still works after sealing, a new type
+         * goes into the regular index and from then on lookups that miss the sealed index also probe
+         * the regular one. Sealing again includes the new types.
+         *
+         * \return False when there is nothing to seal or no perfect hash could be found, lookups then stay as they were.
+         */
+        RTTR_API bool sealRegistry();
+
+        /*!
+         * \brief Returns the number of bytes saveRegistrySnapshot needs for the current registry.
+         */
+        RTTR_API u64 getRegistrySnapshotSize();
+
+        /*!
+         * \brief Writes all registered types (names, raw types, ancestors and the name index) into \a image.
+         *
+         * The image has no pointers, only ids and offsets, so it can be written to a file and mapped
+         * into a later run of the same executable. \a image must be 8-byte aligned.
+         *
+         * \return The number of bytes written, or 0 when \a size is smaller than getRegistrySnapshotSize() or
+         *         when an unregistered id has not been reused yet, or an id reserved by loadTypeProfile not taken yet.
+         */
+        RTTR_API u64 saveRegistrySnapshot(void *image, u64 size);
+
+        /*!
+         * \brief Fills an empty registry from a snapshot image made by saveRegistrySnapshot.
+         *
+         * Every type in the image keeps its id. A later registration of such a type finds it without
+         * taking the lock and only checks its raw type and base classes against the image, types that
+         * are not in the image are added after it as usual.
+         *
+         * \remark The names are used in place, \a image must stay valid (and mapped) for as long as the
+         *         registry is used. It has to be called before the first type is registered, that is from
+         *         the first static initializer, or right after impl::pushRegistry().
+         *
+         * \return False when the registry is not empty or the image is not a valid snapshot for this build. The
+         *         counts, ids, ancestor spans and names of the image are all checked before any is used, a
+         *         truncated or damaged image is rejected and leaves the registry empty.
+         */
+        RTTR_API bool loadRegistrySnapshot(const void *image, u64 size);
+
+        /*!
+         * This structure reports how well the cast cache of the calling thread works.
+         *
+         * Every thread remembers the last results of type_info_t::isTypeDerivedFrom (and so of
+         * rttr_cast) in a small direct-mapped cache keyed by both type ids. Registering a type
+         * clears the caches of all threads. With RTTR_ENABLE_CAST_CACHE set to 0 both counters stay 0.
+         */
+        struct cast_cache_stats_t
+        {
+            u64 m_hits;    //!< Number of lookups answered by the cache
+            u64 m_misses;  //!< Number of lookups that had to look at the ancestors
+        };
+
+        /*!
+         * \brief Fills \a stats with the cast cache counters of the calling thread.
+         */
+        RTTR_API void getCastCacheStats(cast_cache_stats_t &stats);
+
+        /*!
+         * \brief Sets the cast cache counters of the calling thread back to 0.
+         */
+        RTTR_API void resetCastCacheStats();
+
+        /*!
+         * The durations of one kind of call, in buckets of powers of two nanoseconds.
+         */
+        struct timing_histogram_t
+        {
+            u64 m_calls;                               //!< Number of timed calls
+            u64 m_total_ns;                            //!< Sum of the durations of all calls
+            u64 m_buckets[RTTR_STATS_HISTOGRAM_SIZE];  //!< Bucket i counts the calls that took [2^i, 2^(i+1)) nanoseconds, bucket 0 also those under 1
+        };
+
+        /*!
+         * This structure reports what the registry did since the start of the program (or the last reset).
+         *
+         * Every thread counts into its own shard, so counting costs no atomic operations, the counts of
+         * a thread that exited are kept. With RTTR_ENABLE_STATS set to 0 (the default) no counting or
+         * timing code is compiled in and everything stays 0.
+         */
+        struct registry_counters_t
+        {
+            u64                m_registrations;      //!< Calls that registered a type, including the ones that found it registered already
+            u64                m_inserted_types;     //!< Registrations that added a type
+            u64                m_lookups;            //!< Lookups by name (type_info_t::find, impl::findType)
+            u64                m_lookup_misses;      //!< Lookups by name that did not find a type
+            u64                m_index_rebuilds;     //!< Number of times the name index was grown or cleared of removed types
+            u64                m_derived_checks;     //!< Calls to type_info_t::isTypeDerivedFrom, including the ones made by rttr_cast
+            u64                m_ancestor_scans;     //!< Checks that had to scan the ancestors that are not on the primary chain
+            u64                m_scanned_ancestors;  //!< Length of all those scans, divide by m_ancestor_scans for the average
+            u64                m_casts;              //!< Calls to rttr_cast that needed a runtime check (downcasts)
+            u64                m_failed_casts;       //!< Calls to rttr_cast that returned NULL
+            timing_histogram_t m_registration;       //!< Durations of registrations
+            timing_histogram_t m_lookup;             //!< Durations of lookups by name
+            timing_histogram_t m_index_rebuild;      //!< Durations of name index rebuilds
+            timing_histogram_t m_derived_check;      //!< Durations of isTypeDerivedFrom
+            timing_histogram_t m_cast;               //!< Durations of rttr_cast runtime checks
+        };
+
+        /*!
+         * \brief Fills \a counters with the sum of the counters of all threads.
+         *
+         * \remark The shards of other threads are read while they count, a counter can be behind by the calls
+         *         that are running, so take the snapshot when the registry is quiet for exact numbers.
+         */
+        RTTR_API void getRegistryCounters(registry_counters_t &counters);
+
+        /*!
+         * \brief Sets the counters of all threads back to 0.
+         */
+        RTTR_API void resetRegistryCounters();
+
+        namespace impl
+        {
+            /*!
+             * \brief The clock of the timing histograms in nanoseconds, used by rttr_cast when RTTR_ENABLE_STATS is set.
+             */
+            RTTR_API u64 statsClock();
+
+            /*!
+             * \brief Counts a runtime checked rttr_cast that started at \a start (statsClock()).
+             */
+            RTTR_API void statsRecordCast(u64 start, bool succeeded);
+        }  // end namespace impl
+
+        enum trace_op_t
+        {
+            TRACE_REGISTER      = 1,  //!< A type was registered (or found registered)
+            TRACE_DERIVED_CHECK = 2,  //!< type_info_t::isTypeDerivedFrom
+            TRACE_CAST          = 3,  //!< rttr_cast that needed a runtime check
+        };
+
+        enum trace_format_t
+        {
+            TRACE_FORMAT_BINARY = 0,  //!< A trace_file_header_t followed by the trace_event_t records
+            TRACE_FORMAT_CSV    = 1,  //!< One line per event, with the names of both types
+        };
+
+        /*!
+         * One event of the trace.
+         */
+        struct trace_event_t
+        {
+            u64       m_time_ns;  //!< Time of the event on a steady clock
+            type_id_t m_source;   //!< The registered type, the type that is checked, or the type of the cast object (0 for NULL)
+            type_id_t m_target;   //!< The raw type of the registered type, the type that is checked against, or the type cast to
+            u16       m_thread;   //!< Number of the thread, in the order the threads recorded their first event
+            u8        m_op;       //!< One of trace_op_t
+            u8        m_result;   //!< 1 when the type was added, derives from the target, or the cast succeeded
+        };
+
+        /*!
+         * The start of a binary trace file, a file that is drained into more than once has a single header.
+         */
+        struct trace_file_header_t
+        {
+            u32 m_magic;      //!< 'RTTE'
+            u32 m_version;    //!< 1
+            u32 m_eventSize;  //!< sizeof(trace_event_t)
+            u32 m_idSize;     //!< sizeof(type_id_t)
+        };
+
+        /*!
+         * \brief Starts or stops recording events, this only works when RTTR_ENABLE_TRACE is set.
+         *
+         * Every thread that records gets its own ring buffer of RTTR_TRACE_BUFFER_SIZE events, written
+         * without locks or atomic read-modify-writes. While recording is off, a traced call costs one
+         * predictable branch.
+         */
+        RTTR_API void setTraceEnabled(bool enabled);
+
+        /*!
+         * \brief Moves the recorded events of all threads into \a events, the oldest events of each thread first.
+         *
+         * \remark Events that were overwritten because a ring buffer was full are lost. The events of a
+         *         thread that exited are kept until they are drained.
+         *
+         * \return The number of events written, less than \a capacity when all events were drained.
+         */
+        RTTR_API u32 drainTraceEvents(trace_event_t *events, u32 capacity);
+
+        /*!
+         * \brief Drains all recorded events and appends them to the file at \a path in \a format.
+         *
+         * \return False when the file could not be written or RTTR_ENABLE_TRACE is not set.
+         */
+        RTTR_API bool drainTraceToFile(const char *path, trace_format_t format);
+
+        /*!
+         * One type of a hotness profile, see loadTypeProfile.
+         */
+        struct type_profile_entry_t
+        {
+            u64 m_stableId;   //!< type_info_t::getStableId() of the type
+            u32 m_ancestors;  //!< Number of ancestors of the type, the size of the span that is reserved for them
+            u32 m_uses;       //!< Number of events the type was part of, not used by loadTypeProfile
+        };
+
+        /*!
+         * \brief Makes a hotness profile from recorded trace events, the types seen most come first.
+         *
+         * A type counts once for every event it is the source or target of, the raw type of a pointer
+         * type counts along with it since its record and ancestors are what a check reads. The profile
+         * only has stable ids, so it can be stored and loaded by a later run with loadTypeProfile.
+         *
+         * \remark The ids in \a events have to be ids of the current registry, so this is called in the
+         *         run that recorded them (a binary trace file of that run can be read back for this).
+         *
+         * \return The number of entries written, at most \a capacity.
+         */
+        RTTR_API u32 makeTypeProfile(const trace_event_t *events, u32 eventCount, type_profile_entry_t *entries, u32 capacity);
+
+        /*!
+         * \brief Reserves the lowest ids of an empty registry for the types of a hotness profile.
+         *
+         * Types get their id in registration order, which is the order of static initialization, so
+         * the types that are used most end up spread over the registry. The types in \a entries get
+         * ids 1 to \a count in profile order when they are registered, and their ancestor sets are
+         * reserved back to back at the start of the ancestor table. The records and ancestors of the
+         * hot types then share cache lines. Types that are not in the profile get ids after it.
+         *
+         * Nothing else changes: lookups, checks and casts give the same results with or without a
+         * profile. A type whose ancestors no longer fit the reserved span (the profile is from an
+         * older build) still gets its reserved id, its ancestors are added at the end of the table.
+         *
+         * \remark Like loadRegistrySnapshot it has to be called before the first type is registered,
+         *         and a registry can not have both. Until every reserved type is registered the
+         *         registry can not be saved as a snapshot.
+         *
+         * \return False when the registry is not empty, or \a entries has a stable id of 0, the same
+         *         stable id twice, or more types than fit.
+         */
+        RTTR_API bool loadTypeProfile(const type_profile_entry_t *entries, u32 count);
+
+        namespace impl
+        {
+#if RTTR_ENABLE_TRACE
+            RTTR_API extern std::atomic<bool> g_traceEnabled;
+
+            //! The one branch of a traced call while recording is off
+            RTTR_FORCE_INLINE bool isTracing() { return g_traceEnabled.load(std::memory_order_relaxed); }
+#endif
+
+            /*!
+             * \brief Records an event in the ring buffer of the calling thread.
+             */
+            RTTR_API void traceEvent(trace_op_t op, type_id_t source, type_id_t target, bool result);
+        }  // end namespace impl
+
+    }  // end namespace nrtti
+}  // namespace ncore
+
+#endif  // __CRTTR_C_TYPE_REGISTRY_H__
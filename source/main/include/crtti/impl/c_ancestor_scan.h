@@ -0,0 +1,145 @@
+#ifndef __CRTTR_IMPL_C_ANCESTOR_SCAN_H__
+#define __CRTTR_IMPL_C_ANCESTOR_SCAN_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "crtti/c_type_info.h"
+
+#define RTTR_ANCESTOR_SCAN_SCALAR 1
+#define RTTR_ANCESTOR_SCAN_SSE2   2
+#define RTTR_ANCESTOR_SCAN_AVX2   3
+
+// The kernel used to search a list of ancestors, picked from the target instruction set unless defined
+#ifndef RTTR_ANCESTOR_SCAN
+#    if defined(__AVX2__)
+#        define RTTR_ANCESTOR_SCAN RTTR_ANCESTOR_SCAN_AVX2
+#    elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#        define RTTR_ANCESTOR_SCAN RTTR_ANCESTOR_SCAN_SSE2
+#    else
+#        define RTTR_ANCESTOR_SCAN RTTR_ANCESTOR_SCAN_SCALAR
+#    endif
+#endif
+
+#if RTTR_ANCESTOR_SCAN == RTTR_ANCESTOR_SCAN_AVX2
+#    include <immintrin.h>
+#elif RTTR_ANCESTOR_SCAN == RTTR_ANCESTOR_SCAN_SSE2
+#    include <emmintrin.h>
+#endif
+
+namespace ncore
+{
+    namespace nrtti
+    {
+        namespace impl
+        {
+            /*!
+             * \brief Returns true if \a id is one of the first \a count entries of \a list, one entry at a time.
+             */
+            RTTR_FORCE_INLINE bool findAncestorScalar(type_id_t const *list, u32 count, type_id_t id)
+            {
+                for (u32 i = 0; i < count; ++i)
+                {
+                    if (list[i] == id)
+                        return true;
+                }
+                return false;
+            }
+
+#if RTTR_ANCESTOR_SCAN == RTTR_ANCESTOR_SCAN_SSE2 || RTTR_ANCESTOR_SCAN == RTTR_ANCESTOR_SCAN_AVX2
+            // Number of ids per 128-bit vector, 8 of 16 bits or 4 of 32 bits
+            enum
+            {
+                ANCESTOR_SCAN_LANES = 16 / sizeof(type_id_t)
+            };
+
+            RTTR_FORCE_INLINE __m128i splatAncestorSSE2(type_id_t id)
+            {
+#    if RTTR_TYPE_ID_BITS == 32
+                return _mm_set1_epi32((int)id);
+#    else
+                return _mm_set1_epi16((short)id);
+#    endif
+            }
+
+            RTTR_FORCE_INLINE int matchAncestorSSE2(__m128i ids, __m128i key)
+            {
+#    if RTTR_TYPE_ID_BITS == 32
+                return _mm_movemask_epi8(_mm_cmpeq_epi32(ids, key));
+#    else
+                return _mm_movemask_epi8(_mm_cmpeq_epi16(ids, key));
+#    endif
+            }
+
+            /*!
+             * \brief Same as findAncestorScalar, compares 16 bytes of ids per instruction, the rest one at a time.
+             */
+            RTTR_FORCE_INLINE bool findAncestorSSE2(type_id_t const *list, u32 count, type_id_t id)
+            {
+                __m128i const key = splatAncestorSSE2(id);
+                u32           i   = 0;
+                for (; i + ANCESTOR_SCAN_LANES <= count; i += ANCESTOR_SCAN_LANES)
+                {
+                    __m128i const ids = _mm_loadu_si128((__m128i const *)(list + i));
+                    if (matchAncestorSSE2(ids, key) != 0)
+                        return true;
+                }
+                return findAncestorScalar(list + i, count - i, id);
+            }
+#endif
+
+#if RTTR_ANCESTOR_SCAN == RTTR_ANCESTOR_SCAN_AVX2
+            RTTR_FORCE_INLINE __m256i splatAncestorAVX2(type_id_t id)
+            {
+#    if RTTR_TYPE_ID_BITS == 32
+                return _mm256_set1_epi32((int)id);
+#    else
+                return _mm256_set1_epi16((short)id);
+#    endif
+            }
+
+            RTTR_FORCE_INLINE int matchAncestorAVX2(__m256i ids, __m256i key)
+            {
+#    if RTTR_TYPE_ID_BITS == 32
+                return _mm256_movemask_epi8(_mm256_cmpeq_epi32(ids, key));
+#    else
+                return _mm256_movemask_epi8(_mm256_cmpeq_epi16(ids, key));
+#    endif
+            }
+
+            /*!
+             * \brief Same as findAncestorScalar, compares 32 bytes of ids per instruction, the rest 16 bytes or one at a time.
+             */
+            RTTR_FORCE_INLINE bool findAncestorAVX2(type_id_t const *list, u32 count, type_id_t id)
+            {
+                __m256i const key = splatAncestorAVX2(id);
+                u32           i   = 0;
+                for (; i + 2 * ANCESTOR_SCAN_LANES <= count; i += 2 * ANCESTOR_SCAN_LANES)
+                {
+                    __m256i const ids = _mm256_loadu_si256((__m256i const *)(list + i));
+                    if (matchAncestorAVX2(ids, key) != 0)
+                        return true;
+                }
+                return findAncestorSSE2(list + i, count - i, id);
+            }
+#endif
+
+            /*!
+             * \brief Returns true if \a id is one of the first \a count entries of \a list, using the kernel selected by RTTR_ANCESTOR_SCAN.
+             */
+            RTTR_FORCE_INLINE bool findAncestor(type_id_t const *list, u32 count, type_id_t id)
+            {
+#if RTTR_ANCESTOR_SCAN == RTTR_ANCESTOR_SCAN_AVX2
+                return findAncestorAVX2(list, count, id);
+#elif RTTR_ANCESTOR_SCAN == RTTR_ANCESTOR_SCAN_SSE2
+                return findAncestorSSE2(list, count, id);
+#else
+                return findAncestorScalar(list, count, id);
+#endif
+            }
+        }  // end namespace impl
+    }  // end namespace nrtti
+}  // namespace ncore
+
+#endif  // __CRTTR_IMPL_C_ANCESTOR_SCAN_H__
@@ -1,7 +1,54 @@
 #include "crtti/c_type_info.h"
+#include "crtti/c_type_registry.h"
 #include "crtti/base/c_type_traits.h"
 #include "crtti/base/c_static_assert.h"
 
+namespace ncore
+{
+    namespace nrtti
+    {
+        namespace impl
+        {
+            /*!
+             * True when casting \a Arg to \a T is an upcast or an identity cast, this is known to
+             * succeed at compile time so no type information has to be read.
+             */
+            template <typename T, typename Arg>
+            struct is_static_cast_t : Traits::integral_constant<bool, Traits::is_base_of<typename Traits::remove_cv<typename Traits::remove_pointer<T>::type>::type, typename Traits::remove_cv<typename Traits::remove_pointer<Arg>::type>::type>::value>
+            {
+            };
+
+            //! Upcast or identity cast, static_cast already maps NULL to NULL
+            template <typename T, typename Arg>
+            RTTR_INLINE T rttr_cast_impl(Arg object, Traits::true_type)
+            {
+                return static_cast<T>(object);
+            }
+
+            //! Downcast, only the type_info_t of the object can tell if it is valid
+            template <typename T, typename Arg>
+            RTTR_INLINE T rttr_cast_impl(Arg object, Traits::false_type)
+            {
+#if RTTR_ENABLE_STATS
+                u64 const start = statsClock();
+#endif
+                bool const succeeded = object && object->getTypeInfo().template isTypeDerivedFrom<T>();
+#if RTTR_ENABLE_STATS
+                statsRecordCast(start, succeeded);
+#endif
+#if RTTR_ENABLE_TRACE
+                if (isTracing())
+                    traceEvent(TRACE_CAST, object ? object->getTypeInfo().getId() : 0, metatype_info_t<T>::getTypeInfo().getId(), succeeded);
+#endif
+                if (succeeded)
+                    return static_cast<T>(object);
+                else
+                    return NULL;
+            }
+        }  // end namespace impl
+    }  // end namespace nrtti
+}  // namespace ncore
+
 template <typename T, typename Arg>
 RTTR_INLINE T rttr_cast(Arg object)
 {
@@ -14,8 +61,5 @@ RTTR_INLINE T rttr_cast(Arg object)
     typedef typename remove_pointer<T>::type   ReturnType;
     typedef typename remove_pointer<Arg>::type ArgType;
     RTTR_STATIC_ASSERT((is_const<ArgType>::value && is_const<ReturnType>::value) || (!is_const<ArgType>::value && is_const<ReturnType>::value) || (!is_const<ArgType>::value && !is_const<ReturnType>::value), RETURN_TYPE_MUST_HAVE_CONST_QUALIFIER);
-    if (object && object->getTypeInfo().template isTypeDerivedFrom<T>())
-        return static_cast<T>(object);
-    else
-        return NULL;
+    return ncore::nrtti::impl::rttr_cast_impl<T>(object, typename ncore::nrtti::impl::is_static_cast_t<T, Arg>::type());
 }
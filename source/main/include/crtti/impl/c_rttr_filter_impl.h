@@ -0,0 +1,101 @@
+#include "crtti/c_type_info.h"
+#include "crtti/base/c_type_traits.h"
+#include "crtti/base/c_static_assert.h"
+
+namespace ncore
+{
+    namespace nrtti
+    {
+        RTTR_INLINE type_info_t derived_type_set_t::getTarget() const { return m_target; }
+        RTTR_INLINE u32         derived_type_set_t::getCount() const { return m_count; }
+
+        RTTR_INLINE bool derived_type_set_t::contains(type_id_t id) const
+        {
+            if (id < m_count)
+            {
+                u64 const *word = m_bits + ((id >> 6) << 1);
+                u64 const  bit  = (u64)1 << (id & 63);
+                if ((word[1] & bit) == 0)
+                    return (word[0] & bit) != 0;
+            }
+            return containsUncovered(id);
+        }
+
+        namespace impl
+        {
+            // Number of objects whose type ids are gathered before they are tested against the set
+            enum
+            {
+                FILTER_BLOCK_SIZE = 64
+            };
+
+            RTTR_INLINE u32 filter_block_size(u32 count, u32 block) { return (count - block) < (u32)FILTER_BLOCK_SIZE ? (count - block) : (u32)FILTER_BLOCK_SIZE; }
+
+            // Tests the type ids of one block of at most 64 objects, bit i is set when object i matches.
+            // The virtual getTypeInfo() calls are done first, the set lookups after that are a tight loop.
+            template <typename Arg>
+            RTTR_INLINE u64 filter_block(const derived_type_set_t &set, Arg const *objects, u32 count)
+            {
+                type_id_t ids[FILTER_BLOCK_SIZE];
+                for (u32 i = 0; i < count; ++i)
+                    ids[i] = objects[i] != NULL ? objects[i]->getTypeInfo().getId() : 0;
+
+                u64 bits = 0;
+                for (u32 i = 0; i < count; ++i)
+                    bits |= (u64)(set.contains(ids[i]) ? 1 : 0) << i;
+                return bits;
+            }
+        }  // end namespace impl
+    }  // end namespace nrtti
+}  // namespace ncore
+
+template <typename T, typename Arg>
+RTTR_INLINE ncore::u32 rttr_filter(const ncore::nrtti::derived_type_set_t &set, Arg const *objects, ncore::u32 count, T *out)
+{
+    using namespace ncore;
+    using namespace ncore::nrtti::Traits;
+
+    RTTR_STATIC_ASSERT(is_pointer<T>::value, RETURN_TYPE_MUST_BE_A_POINTER);
+    RTTR_STATIC_ASSERT(is_pointer<Arg>::value, ARGUMENT_TYPE_MUST_BE_A_POINTER);
+    RTTR_STATIC_ASSERT(ncore::nrtti::impl::has_getTypeInfo_func<Arg>::value, CLASS_HAS_NO_TYPEINFO_DEFINIED__USE_MACRO_ENABLE_RTTI);
+
+    u32 n = 0;
+    for (u32 block = 0; block < count; block += ncore::nrtti::impl::FILTER_BLOCK_SIZE)
+    {
+        u32 const size = ncore::nrtti::impl::filter_block_size(count, block);
+        u64 const bits = ncore::nrtti::impl::filter_block(set, objects + block, size);
+
+        // always write, only advance on a match, this keeps the loop free of branches. Only a match is
+        // cast, a static_cast to a type the object does not have is undefined (the select becomes a cmov).
+        for (u32 i = 0; i < size; ++i)
+        {
+            u32 const match = (u32)((bits >> i) & 1);
+            out[n]          = match ? static_cast<T>(objects[block + i]) : nullptr;
+            n += match;
+        }
+    }
+    return n;
+}
+
+template <typename T, typename Arg>
+RTTR_INLINE ncore::u32 rttr_filter(Arg const *objects, ncore::u32 count, T *out)
+{
+    ncore::nrtti::derived_type_set_t const set(ncore::nrtti::type_info_t::get<T>());
+    return rttr_filter<T>(set, objects, count, out);
+}
+
+template <typename Arg>
+RTTR_INLINE void rttr_filter_mask(const ncore::nrtti::derived_type_set_t &set, Arg const *objects, ncore::u32 count, ncore::u64 *outMask)
+{
+    using namespace ncore;
+    using namespace ncore::nrtti::Traits;
+
+    RTTR_STATIC_ASSERT(is_pointer<Arg>::value, ARGUMENT_TYPE_MUST_BE_A_POINTER);
+    RTTR_STATIC_ASSERT(ncore::nrtti::impl::has_getTypeInfo_func<Arg>::value, CLASS_HAS_NO_TYPEINFO_DEFINIED__USE_MACRO_ENABLE_RTTI);
+
+    for (u32 block = 0; block < count; block += ncore::nrtti::impl::FILTER_BLOCK_SIZE)
+    {
+        u32 const size      = ncore::nrtti::impl::filter_block_size(count, block);
+        outMask[block >> 6] = ncore::nrtti::impl::filter_block(set, objects + block, size);
+    }
+}
@@ -6,31 +6,37 @@ namespace ncore
     {
         RTTR_INLINE type_info_t::type_info_t()
             : m_id(0)
+            , m_generation(0)
         {
         }
 
-        RTTR_INLINE type_info_t::type_info_t(type_id_t id)
+        RTTR_INLINE type_info_t::type_info_t(type_id_t id, u16 generation)
             : m_id(id)
+            , m_generation(generation)
         {
         }
 
         RTTR_INLINE type_info_t::type_info_t(const type_info_t &other)
             : m_id(other.m_id)
+            , m_generation(other.m_generation)
         {
         }
 
         RTTR_INLINE type_info_t &type_info_t::operator=(const type_info_t &other)
         {
-            m_id = other.m_id;
+            m_id         = other.m_id;
+            m_generation = other.m_generation;
             return *this;
         }
 
-        RTTR_INLINE bool      type_info_t::operator<(const type_info_t &other) const { return (m_id < other.m_id); }
-        RTTR_INLINE bool      type_info_t::operator>(const type_info_t &other) const { return (m_id > other.m_id); }
-        RTTR_INLINE bool      type_info_t::operator>=(const type_info_t &other) const { return (m_id >= other.m_id); }
-        RTTR_INLINE bool      type_info_t::operator<=(const type_info_t &other) const { return (m_id <= other.m_id); }
-        RTTR_INLINE bool      type_info_t::operator==(const type_info_t &other) const { return (m_id == other.m_id); }
-        RTTR_INLINE bool      type_info_t::operator!=(const type_info_t &other) const { return (m_id != other.m_id); }
+        // Orders on the id first, a stale type_info_t and the one of the type that reuses its id differ in the generation
+        RTTR_INLINE u64       type_info_t::getKey() const { return ((u64)m_id << 16) | m_generation; }
+        RTTR_INLINE bool      type_info_t::operator<(const type_info_t &other) const { return (getKey() < other.getKey()); }
+        RTTR_INLINE bool      type_info_t::operator>(const type_info_t &other) const { return (getKey() > other.getKey()); }
+        RTTR_INLINE bool      type_info_t::operator>=(const type_info_t &other) const { return (getKey() >= other.getKey()); }
+        RTTR_INLINE bool      type_info_t::operator<=(const type_info_t &other) const { return (getKey() <= other.getKey()); }
+        RTTR_INLINE bool      type_info_t::operator==(const type_info_t &other) const { return (getKey() == other.getKey()); }
+        RTTR_INLINE bool      type_info_t::operator!=(const type_info_t &other) const { return (getKey() != other.getKey()); }
         RTTR_INLINE type_id_t type_info_t::getId() const { return m_id; }
         RTTR_INLINE bool      type_info_t::isValid() const { return (m_id != 0); }
 
@@ -166,6 +172,10 @@ namespace ncore
 #define RTTR_CAT_IMPL(a, b) a##b
 #define RTTR_CAT(a, b)      RTTR_CAT_IMPL(a, b)
 
+// The stable id of type T at compile time, T must be spelled as in RTTR_DECLARE_META_TYPE(T), including
+// the whitespace between tokens, so RTTR_STABLE_ID(MyClass *) for the variants of RTTR_DECLARE_STANDARD_META_TYPE_VARIANTS
+#define RTTR_STABLE_ID(T) ncore::nrtti::impl::stableIdOf(#T, sizeof(#T) - 1)
+
 #define RTTR_DECLARE_META_TYPE(T)                                                                                     \
     namespace ncore                                                                                                   \
     {                                                                                                                 \
@@ -182,11 +192,8 @@ namespace ncore
                     };                                                                                                \
                     static RTTR_INLINE nrtti::type_info_t getTypeInfo()                                               \
                     {                                                                                                 \
-                        int const   maximum = 32;                                                                     \
-                        type_info_t outArray[maximum];                                                                \
-                        int         i = 0;                                                                            \
-                        base_classes<T>::retrieve(outArray, i, maximum);                                              \
-                        static const type_info_t val = registerOrGetType(#T, raw_type_info_t<T>::get(), outArray, i); \
+                        constexpr u64            hash = RTTR_STABLE_ID(T);                                            \
+                        static const type_info_t val  = registerMetaType<T>(#T, sizeof(#T) - 1, hash);                \
                         return val;                                                                                   \
                     }                                                                                                 \
                 };                                                                                                    \
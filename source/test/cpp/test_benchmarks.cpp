@@ -0,0 +1,966 @@
+#include "crttr/test_classes.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+
+#include "crtti/c_rttr.h"
+#include "crtti/impl/c_ancestor_scan.h"
+#include "cunittest/cunittest.h"
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// A single inheritance chain of 17 levels, and a sibling branch to have casts that fail
+
+template <int N>
+struct bench_level_t : bench_level_t<N - 1>
+{
+    RTTR_ENABLE_DERIVED_FROM(bench_level_t<N - 1>)
+};
+
+template <>
+struct bench_level_t<0>
+{
+    virtual ~bench_level_t() {}
+    RTTR_ENABLE()
+};
+
+struct bench_sibling_t : bench_level_t<1>
+{
+    RTTR_ENABLE_DERIVED_FROM(bench_level_t<1>)
+};
+
+RTTR_DECLARE_STANDARD_META_TYPE_VARIANTS(bench_level_t<0>)
+RTTR_DECLARE_STANDARD_META_TYPE_VARIANTS(bench_level_t<1>)
+RTTR_DECLARE_STANDARD_META_TYPE_VARIANTS(bench_level_t<2>)
+RTTR_DECLARE_STANDARD_META_TYPE_VARIANTS(bench_level_t<3>)
+RTTR_DECLARE_STANDARD_META_TYPE_VARIANTS(bench_level_t<4>)
+RTTR_DECLARE_STANDARD_META_TYPE_VARIANTS(bench_level_t<5>)
+RTTR_DECLARE_STANDARD_META_TYPE_VARIANTS(bench_level_t<6>)
+RTTR_DECLARE_STANDARD_META_TYPE_VARIANTS(bench_level_t<7>)
+RTTR_DECLARE_STANDARD_META_TYPE_VARIANTS(bench_level_t<8>)
+RTTR_DECLARE_STANDARD_META_TYPE_VARIANTS(bench_level_t<9>)
+RTTR_DECLARE_STANDARD_META_TYPE_VARIANTS(bench_level_t<10>)
+RTTR_DECLARE_STANDARD_META_TYPE_VARIANTS(bench_level_t<11>)
+RTTR_DECLARE_STANDARD_META_TYPE_VARIANTS(bench_level_t<12>)
+RTTR_DECLARE_STANDARD_META_TYPE_VARIANTS(bench_level_t<13>)
+RTTR_DECLARE_STANDARD_META_TYPE_VARIANTS(bench_level_t<14>)
+RTTR_DECLARE_STANDARD_META_TYPE_VARIANTS(bench_level_t<15>)
+RTTR_DECLARE_STANDARD_META_TYPE_VARIANTS(bench_level_t<16>)
+RTTR_DECLARE_STANDARD_META_TYPE_VARIANTS(bench_sibling_t)
+
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(bench_level_t<0>)
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(bench_level_t<1>)
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(bench_level_t<2>)
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(bench_level_t<3>)
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(bench_level_t<4>)
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(bench_level_t<5>)
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(bench_level_t<6>)
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(bench_level_t<7>)
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(bench_level_t<8>)
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(bench_level_t<9>)
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(bench_level_t<10>)
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(bench_level_t<11>)
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(bench_level_t<12>)
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(bench_level_t<13>)
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(bench_level_t<14>)
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(bench_level_t<15>)
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(bench_level_t<16>)
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(bench_sibling_t)
+
+// Counts how often the type of the object is asked for, an upcast must not ask
+struct bench_counted_t : bench_level_t<16>
+{
+    static ncore::u32 s_calls;
+    virtual ncore::nrtti::type_info_t getTypeInfo() const
+    {
+        ++s_calls;
+        return bench_level_t<16>::getTypeInfo();
+    }
+};
+ncore::u32 bench_counted_t::s_calls = 0;
+
+#if defined(__GXX_RTTI) || defined(_CPPRTTI)
+#    define BENCH_HAS_DYNAMIC_CAST 1
+#endif
+
+using namespace ncore;
+using namespace ncore::nrtti;
+
+namespace
+{
+    typedef std::chrono::steady_clock bench_clock_t;
+
+    struct bench_timer_t
+    {
+        bench_timer_t()
+            : m_start(bench_clock_t::now())
+        {
+        }
+
+        double elapsed_ns() const { return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock_t::now() - m_start).count(); }
+
+        bench_clock_t::time_point m_start;
+    };
+
+    static void bench_report(const char* name, double total_ns, u64 ops) { printf("[bench] %-48s %10.3f ns/op (%llu ops)\n", name, total_ns / (double)ops, (unsigned long long)ops); }
+
+    // Keeps the optimizer from removing the measured work
+    static volatile u32 s_bench_sink = 0;
+
+    // Names for synthetic types, the registry only stores the pointers so they must outlive it
+    static void bench_make_names(std::vector<std::string>& names, const char* prefix, u32 count)
+    {
+        names.resize(count);
+        char buffer[64];
+        for (u32 i = 0; i < count; ++i)
+        {
+            snprintf(buffer, sizeof(buffer), "%s::synthetic_type_%u", prefix, i);
+            names[i] = buffer;
+        }
+    }
+
+    // Names as they come out of the macros for a code base with a lot of templates
+    static void bench_make_corpus(std::vector<std::string>& names, u32 count)
+    {
+        const char* leaves[]    = {"game::component_%u", "ui::widget_%u", "Class%u", "ncore::nrtti::type_%u_t", "render::pass_%u"};
+        const char* templates[] = {"%s", "%s *", "const %s *", "ncore::vector_t<%s>", "ncore::array_t<ncore::pair_t<ncore::string_t, %s>, 16>", "ncore::handle_t<ncore::vector_t<%s, ncore::allocator_t>> *"};
+        u32 const   numLeaves    = sizeof(leaves) / sizeof(leaves[0]);
+        u32 const   numTemplates = sizeof(templates) / sizeof(templates[0]);
+        names.resize(count);
+        char leaf[64], buffer[256];
+        for (u32 i = 0; i < count; ++i)
+        {
+            snprintf(leaf, sizeof(leaf), leaves[i % numLeaves], i / numLeaves);
+            snprintf(buffer, sizeof(buffer), templates[(i / numLeaves) % numTemplates], leaf);
+            names[i] = buffer;
+        }
+    }
+
+    // Hides the dynamic type of an object from the optimizer
+    template <typename T>
+    static T* bench_opaque(T* object)
+    {
+        T* volatile hidden = object;
+        return hidden;
+    }
+
+    // Casts a pointer to the root of the chain to a type near the root (hit) and to the
+    // sibling branch (miss), these have to look at the most ancestors of the object.
+    template <int D>
+    static void bench_cast_depth()
+    {
+        u64 const              iterations = 1000000;
+        bench_level_t<D>       object;
+        bench_level_t<0>* const root = bench_opaque<bench_level_t<0> >(&object);
+        u32                    sum  = 0;
+        char                   name[64];
+
+        {
+            bench_timer_t timer;
+            for (u64 i = 0; i < iterations; ++i)
+                sum += rttr_cast<bench_level_t<1>*>(root) != NULL ? 1 : 0;
+            snprintf(name, sizeof(name), "rttr_cast, depth %2d, hit", D);
+            bench_report(name, timer.elapsed_ns(), iterations);
+        }
+        {
+            bench_timer_t timer;
+            for (u64 i = 0; i < iterations; ++i)
+                sum += rttr_cast<bench_sibling_t*>(root) != NULL ? 1 : 0;
+            snprintf(name, sizeof(name), "rttr_cast, depth %2d, miss", D);
+            bench_report(name, timer.elapsed_ns(), iterations);
+        }
+#ifdef BENCH_HAS_DYNAMIC_CAST
+        {
+            bench_timer_t timer;
+            for (u64 i = 0; i < iterations; ++i)
+                sum += dynamic_cast<bench_level_t<1>*>(root) != NULL ? 1 : 0;
+            snprintf(name, sizeof(name), "dynamic_cast, depth %2d, hit", D);
+            bench_report(name, timer.elapsed_ns(), iterations);
+        }
+        {
+            bench_timer_t timer;
+            for (u64 i = 0; i < iterations; ++i)
+                sum += dynamic_cast<bench_sibling_t*>(root) != NULL ? 1 : 0;
+            snprintf(name, sizeof(name), "dynamic_cast, depth %2d, miss", D);
+            bench_report(name, timer.elapsed_ns(), iterations);
+        }
+#endif
+        s_bench_sink = sum;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////
+    // Replica of the former RTTR_DECLARE_META_TYPE body, which walked all base classes into
+    // a 32-entry stack array on every getTypeInfo() call before reading the static.
+
+    template <class>
+    struct legacy_fill_t;
+
+    template <typename T>
+    struct legacy_metatype_t
+    {
+        static type_info_t getTypeInfo()
+        {
+            type_info_t outArray[32];
+            int         i = 0;
+            legacy_fill_t<typename T::baseClassList>::fill(outArray, i);
+            static const type_info_t val = impl::registerOrGetType(type_info_t::get<T>().getName(), impl::raw_type_info_t<T>::get(), outArray, i);
+            return val;
+        }
+    };
+
+    template <>
+    struct legacy_fill_t<impl::typelist_t<>>
+    {
+        static void fill(type_info_t*, int&) {}
+    };
+
+    template <class T, class... U>
+    struct legacy_fill_t<impl::typelist_t<T, U...>>
+    {
+        static void fill(type_info_t* outArray, int& i)
+        {
+            outArray[i++] = legacy_metatype_t<T>::getTypeInfo();
+            legacy_fill_t<typename T::baseClassList>::fill(outArray, i);
+            legacy_fill_t<impl::typelist_t<U...>>::fill(outArray, i);
+        }
+    };
+}  // namespace
+
+UNITTEST_SUITE_BEGIN(benchmarks)
+{
+    UNITTEST_FIXTURE(type_info)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(get_5_deep_hierarchy)
+        {
+            u64 const iterations = 1000000;
+
+            // ClassSingle5A -> 4A -> 3A -> 2A -> 1A -> ClassSingleBase
+            CHECK_TRUE(legacy_metatype_t<ClassSingle5A>::getTypeInfo() == type_info_t::get<ClassSingle5A>());
+
+            u32 sum = 0;
+            {
+                bench_timer_t timer;
+                for (u64 i = 0; i < iterations; ++i)
+                    sum += legacy_metatype_t<ClassSingle5A>::getTypeInfo().getId();
+                bench_report("get<T>(), 5 deep, base walk per call (before)", timer.elapsed_ns(), iterations);
+            }
+            {
+                bench_timer_t timer;
+                for (u64 i = 0; i < iterations; ++i)
+                    sum += type_info_t::get<ClassSingle5A>().getId();
+                bench_report("get<T>(), 5 deep, single static read (after)", timer.elapsed_ns(), iterations);
+            }
+            s_bench_sink = sum;
+        }
+    }
+
+    UNITTEST_FIXTURE(cast)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(hierarchy_depth)
+        {
+            bench_level_t<16> object;
+            CHECK_TRUE(rttr_cast<bench_level_t<1>*>((bench_level_t<0>*)&object) != NULL);
+            CHECK_TRUE(rttr_cast<bench_sibling_t*>((bench_level_t<0>*)&object) == NULL);
+
+            bench_cast_depth<1>();
+            bench_cast_depth<4>();
+            bench_cast_depth<16>();
+        }
+
+        UNITTEST_TEST(static_upcast)
+        {
+            static_assert(impl::is_static_cast_t<bench_level_t<0>*, bench_level_t<16>*>::value, "upcast");
+            static_assert(impl::is_static_cast_t<const bench_level_t<16>*, bench_level_t<16>*>::value, "identity");
+            static_assert(!impl::is_static_cast_t<bench_level_t<16>*, bench_level_t<0>*>::value, "downcast");
+
+            bench_counted_t  object;
+            bench_counted_t* null = NULL;
+            bench_counted_t::s_calls = 0;
+            CHECK_TRUE(rttr_cast<bench_level_t<0>*>(&object) == &object);
+            CHECK_TRUE(rttr_cast<bench_counted_t*>(&object) == &object);
+            CHECK_TRUE(rttr_cast<bench_level_t<8>*>(null) == NULL);
+            CHECK_EQUAL((u32)0, bench_counted_t::s_calls);
+            CHECK_TRUE(rttr_cast<bench_level_t<16>*>((bench_level_t<0>*)&object) == &object);
+            CHECK_EQUAL((u32)1, bench_counted_t::s_calls);
+
+            u64 const                iterations = 1000000;
+            bench_level_t<16>        leaf;
+            bench_level_t<16>* const from = bench_opaque(&leaf);
+            u32                      sum  = 0;
+            {
+                bench_timer_t timer;
+                for (u64 i = 0; i < iterations; ++i)
+                    sum += impl::rttr_cast_impl<bench_level_t<1>*>(from, Traits::false_type()) != NULL ? 1 : 0;
+                bench_report("rttr_cast, depth 16, upcast, runtime check (before)", timer.elapsed_ns(), iterations);
+            }
+            {
+                bench_timer_t timer;
+                for (u64 i = 0; i < iterations; ++i)
+                    sum += rttr_cast<bench_level_t<1>*>(from) != NULL ? 1 : 0;
+                bench_report("rttr_cast, depth 16, upcast, static (after)", timer.elapsed_ns(), iterations);
+            }
+            s_bench_sink = sum;
+        }
+
+        UNITTEST_TEST(multiple_inheritance)
+        {
+            // FinalClass has 5 direct bases, ClassMultipleBaseE is the last of its 35 ancestors
+            u64 const         iterations = 1000000;
+            FinalClass        object;
+            type_info_t const info   = type_info_t::get(*bench_opaque(&object));
+            type_info_t const target = type_info_t::get<ClassMultipleBaseE>();
+            u32               sum    = 0;
+
+            resetCastCacheStats();
+            {
+                bench_timer_t timer;
+                for (u64 i = 0; i < iterations; ++i)
+                    sum += info.isTypeDerivedFrom(target) ? 1 : 0;
+                bench_report("isTypeDerivedFrom, 35 ancestors, last base", timer.elapsed_ns(), iterations);
+            }
+            s_bench_sink = sum;
+
+            cast_cache_stats_t stats;
+            getCastCacheStats(stats);
+            printf("[bench] cast cache: %llu hits, %llu misses\n", (unsigned long long)stats.m_hits, (unsigned long long)stats.m_misses);
+            CHECK_EQUAL((u32)iterations, sum);
+        }
+    }
+
+    UNITTEST_FIXTURE(ancestor_scan)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(kernels)
+        {
+            // the secondary ancestors of a type are searched after the O(1) primary chain check,
+            // the target is the last entry (hit) or not there (miss)
+            u32 const lengths[] = {4, 8, 16, 32, 64, 128};
+            for (u32 l = 0; l < sizeof(lengths) / sizeof(lengths[0]); ++l)
+            {
+                u32 const              length = lengths[l];
+                std::vector<type_id_t> list(length);
+                for (u32 i = 0; i < length; ++i)
+                    list[i] = (type_id_t)(100 + i * 7);
+                type_id_t const* const ids        = bench_opaque(&list[0]);
+                type_id_t const        hit        = list[length - 1];
+                type_id_t const        miss       = 99;
+                u64 const              iterations = 2000000;
+                u32                    sum        = 0;
+                char                   name[64];
+
+                {
+                    bench_timer_t timer;
+                    for (u64 i = 0; i < iterations; ++i)
+                        sum += impl::findAncestorScalar(ids, length, (i & 1) ? hit : miss) ? 1 : 0;
+                    snprintf(name, sizeof(name), "scan scalar, %3u ancestors", length);
+                    bench_report(name, timer.elapsed_ns(), iterations);
+                }
+#if RTTR_ANCESTOR_SCAN == RTTR_ANCESTOR_SCAN_SSE2 || RTTR_ANCESTOR_SCAN == RTTR_ANCESTOR_SCAN_AVX2
+                {
+                    bench_timer_t timer;
+                    for (u64 i = 0; i < iterations; ++i)
+                        sum += impl::findAncestorSSE2(ids, length, (i & 1) ? hit : miss) ? 1 : 0;
+                    snprintf(name, sizeof(name), "scan sse2,   %3u ancestors", length);
+                    bench_report(name, timer.elapsed_ns(), iterations);
+                }
+#endif
+#if RTTR_ANCESTOR_SCAN == RTTR_ANCESTOR_SCAN_AVX2
+                {
+                    bench_timer_t timer;
+                    for (u64 i = 0; i < iterations; ++i)
+                        sum += impl::findAncestorAVX2(ids, length, (i & 1) ? hit : miss) ? 1 : 0;
+                    snprintf(name, sizeof(name), "scan avx2,   %3u ancestors", length);
+                    bench_report(name, timer.elapsed_ns(), iterations);
+                }
+#endif
+                s_bench_sink = sum;
+            }
+        }
+    }
+
+    UNITTEST_FIXTURE(filter)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(filter_pointers)
+        {
+            // objects at depth 1 to 16 of the chain and the sibling branch, about half derive from bench_level_t<8>
+            bench_level_t<1>  l1;
+            bench_level_t<4>  l4;
+            bench_level_t<8>  l8;
+            bench_level_t<12> l12;
+            bench_level_t<16> l16;
+            bench_sibling_t   sibling;
+            bench_level_t<0>* kinds[] = {&l1, &l8, &l4, &l16, &sibling, &l12};
+
+            u32 const sizes[] = {1000, 100000, 1000000};
+            for (u32 s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+            {
+                u32 const                       count = sizes[s];
+                std::vector<bench_level_t<0>*> objects(count);
+                std::vector<bench_level_t<8>*> out(count);
+                u32                             seed = 12345;
+                for (u32 i = 0; i < count; ++i)
+                {
+                    seed       = seed * 1664525u + 1013904223u;
+                    objects[i] = kinds[(seed >> 16) % (sizeof(kinds) / sizeof(kinds[0]))];
+                }
+
+                u32 const repeat = 10000000 / count;
+                u32       loop   = 0;
+                u32       batch  = 0;
+                char      name[64];
+                {
+                    bench_timer_t timer;
+                    for (u32 r = 0; r < repeat; ++r)
+                    {
+                        u32 n = 0;
+                        for (u32 i = 0; i < count; ++i)
+                        {
+                            bench_level_t<8>* const p = rttr_cast<bench_level_t<8>*>(objects[i]);
+                            if (p != NULL)
+                                out[n++] = p;
+                        }
+                        loop = n;
+                    }
+                    snprintf(name, sizeof(name), "rttr_cast loop, %u pointers", count);
+                    bench_report(name, timer.elapsed_ns(), (u64)repeat * count);
+                }
+                {
+                    derived_type_set_t const set(type_info_t::get<bench_level_t<8> >());
+                    bench_timer_t            timer;
+                    for (u32 r = 0; r < repeat; ++r)
+                        batch = rttr_filter<bench_level_t<8>*>(set, &objects[0], count, &out[0]);
+                    snprintf(name, sizeof(name), "rttr_filter, %u pointers", count);
+                    bench_report(name, timer.elapsed_ns(), (u64)repeat * count);
+                }
+                CHECK_EQUAL(loop, batch);
+            }
+        }
+    }
+
+    UNITTEST_FIXTURE(registry)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(startup_registration)
+        {
+            u32 const counts[] = {1000, 4000, 8000};
+            for (u32 c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+            {
+                u32 const                count = counts[c];
+                std::vector<std::string> names;
+                bench_make_names(names, "startup", count);
+
+                impl::pushRegistry();
+                std::vector<type_id_t> ids(count);
+                {
+                    bench_timer_t timer;
+                    for (u32 i = 0; i < count; ++i)
+                        ids[i] = impl::registerOrGetType(names[i].c_str(), type_info_t(), nullptr, 0).getId();
+                    double const ns = timer.elapsed_ns();
+                    printf("[bench] register %5u types: %10.3f ms total, %8.3f ns/type\n", count, ns / 1000000.0, ns / (double)count);
+                }
+
+                // every registered type must be found again under the same id
+                u32 mismatches = 0;
+                for (u32 i = 0; i < count; ++i)
+                    mismatches += (impl::registerOrGetType(names[i].c_str(), type_info_t(), nullptr, 0).getId() != ids[i]) ? 1 : 0;
+                CHECK_EQUAL((u32)0, mismatches);
+                impl::popRegistry();
+            }
+        }
+
+        UNITTEST_TEST(startup_from_snapshot)
+        {
+            // 8k types, a quarter of them with a base class
+            u32 const                count = 8000;
+            std::vector<std::string> names;
+            bench_make_names(names, "snapshot", count);
+
+            double           withoutSnapshot = 0;
+            u64              size            = 0;
+            std::vector<u64> image;
+            {
+                impl::pushRegistry();
+                bench_timer_t timer;
+                for (u32 i = 0; i < count; ++i)
+                {
+                    type_info_t base = (i % 4) == 0 && i > 0 ? impl::findType(names[i - 1].c_str()) : type_info_t();
+                    impl::registerOrGetType(names[i].c_str(), type_info_t(), &base, base.isValid() ? 1 : 0);
+                }
+                withoutSnapshot = timer.elapsed_ns();
+
+                size = getRegistrySnapshotSize();
+                image.resize((size_t)(size + 7) / 8);
+                saveRegistrySnapshot(&image[0], size);
+                impl::popRegistry();
+            }
+            {
+                impl::pushRegistry();
+                bench_timer_t timer;
+                CHECK_TRUE(loadRegistrySnapshot(&image[0], size));
+                double const loaded = timer.elapsed_ns();
+                for (u32 i = 0; i < count; ++i)
+                {
+                    type_info_t base = (i % 4) == 0 && i > 0 ? impl::findType(names[i - 1].c_str()) : type_info_t();
+                    impl::registerOrGetType(names[i].c_str(), type_info_t(), &base, base.isValid() ? 1 : 0);
+                }
+                double const withSnapshot = timer.elapsed_ns();
+
+                registry_stats_t stats;
+                getRegistryStats(stats);
+                CHECK_EQUAL((u32)0, stats.m_snapshot_mismatches);
+                CHECK_EQUAL(count + 1, stats.m_types);
+                impl::popRegistry();
+
+                bench_report("register 8000 types, no snapshot", withoutSnapshot, count);
+                bench_report("register 8000 types, from snapshot", withSnapshot, count);
+                printf("[bench] snapshot of %u types: %llu bytes, loaded in %.1f us\n", count, (unsigned long long)size, loaded / 1000.0);
+            }
+        }
+
+        UNITTEST_TEST(name_lookup)
+        {
+            u32 const counts[] = {100, 1000, 8000};
+            for (u32 c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+            {
+                u32 const                count = counts[c];
+                std::vector<std::string> names, missing;
+                bench_make_names(names, "lookup", count);
+                bench_make_names(missing, "missing", count);
+
+                impl::pushRegistry();
+                for (u32 i = 0; i < count; ++i)
+                    impl::registerOrGetType(names[i].c_str(), type_info_t(), nullptr, 0);
+
+                u32 const iterations = 1000000;
+                for (u32 sealed = 0; sealed < 2; ++sealed)
+                {
+                    if (sealed)
+                        CHECK_TRUE(sealRegistry());
+
+                    u32 found = 0;
+                    {
+                        bench_timer_t timer;
+                        for (u32 i = 0; i < iterations; ++i)
+                            found += impl::findType(names[i % count].c_str()).isValid() ? 1 : 0;
+                        char name[64];
+                        snprintf(name, sizeof(name), "find type, hit, %u types%s", count, sealed ? ", sealed" : "");
+                        bench_report(name, timer.elapsed_ns(), iterations);
+                    }
+                    CHECK_EQUAL(iterations, found);
+
+                    found = 0;
+                    {
+                        bench_timer_t timer;
+                        for (u32 i = 0; i < iterations; ++i)
+                            found += impl::findType(missing[i % count].c_str()).isValid() ? 1 : 0;
+                        char name[64];
+                        snprintf(name, sizeof(name), "find type, miss, %u types%s", count, sealed ? ", sealed" : "");
+                        bench_report(name, timer.elapsed_ns(), iterations);
+                    }
+                    CHECK_EQUAL((u32)0, found);
+                }
+                impl::popRegistry();
+            }
+        }
+
+        UNITTEST_TEST(name_length)
+        {
+            // short names and template-heavy names, looked up by terminated name and by slice
+            u32 const   count      = 1000;
+            u32 const   iterations = 1000000;
+            const char *formats[]  = {"T%u", "ncore::nrtti::container_t<ncore::pair_t<ncore::string_t, ncore::vector_t<ncore::nrtti::entity_%u, ncore::allocator_t>>, 16>"};
+            const char *labels[]   = {"short", "long"};
+            for (u32 f = 0; f < 2; ++f)
+            {
+                std::vector<std::string> names(count);
+                char                     buffer[256];
+                for (u32 i = 0; i < count; ++i)
+                {
+                    snprintf(buffer, sizeof(buffer), formats[f], i);
+                    names[i] = buffer;
+                }
+
+                impl::pushRegistry();
+                for (u32 i = 0; i < count; ++i)
+                    impl::registerOrGetType(names[i].c_str(), type_info_t(), nullptr, 0);
+
+                u32 found = 0;
+                {
+                    bench_timer_t timer;
+                    for (u32 i = 0; i < iterations; ++i)
+                        found += impl::findType(names[i % count].c_str()).isValid() ? 1 : 0;
+                    snprintf(buffer, sizeof(buffer), "find type, %s names (%u chars)", labels[f], (u32)names[count - 1].size());
+                    bench_report(buffer, timer.elapsed_ns(), iterations);
+                }
+                {
+                    bench_timer_t timer;
+                    for (u32 i = 0; i < iterations; ++i)
+                        found += type_info_t::find(names[i % count].data(), (u32)names[i % count].size()).isValid() ? 1 : 0;
+                    snprintf(buffer, sizeof(buffer), "find type by slice, %s names", labels[f]);
+                    bench_report(buffer, timer.elapsed_ns(), iterations);
+                }
+                CHECK_EQUAL(iterations * 2, found);
+                impl::popRegistry();
+            }
+        }
+
+        UNITTEST_TEST(name_hash)
+        {
+            // registration with the hash computed from the name, and with the hash the macros pass in,
+            // the best of two runs each
+            u32 const                count = 8000;
+            std::vector<std::string> names;
+            bench_make_corpus(names, count);
+
+            u64 bytes = 0;
+            for (u32 i = 0; i < count; ++i)
+                bytes += names[i].size();
+            std::vector<u64> hashes(count);
+            for (u32 i = 0; i < count; ++i)
+                hashes[i] = impl::stableIdOf(names[i].c_str(), (u32)names[i].size());
+
+            u64 elapsed[2];
+            for (u32 run = 0; run < 4; ++run)
+            {
+                u32 const precomputed = run & 1;  // alternated, the first run also warms up the names
+                impl::pushRegistry();
+                {
+                    bench_timer_t timer;
+                    for (u32 i = 0; i < count; ++i)
+                    {
+                        if (precomputed)
+                            impl::registerOrGetType(names[i].c_str(), (u32)names[i].size(), hashes[i], type_info_t(), nullptr, 0);
+                        else
+                            impl::registerOrGetType(names[i].c_str(), type_info_t(), nullptr, 0);
+                    }
+                    u64 const ns = timer.elapsed_ns();
+                    if (run < 2 || ns < elapsed[precomputed])
+                        elapsed[precomputed] = ns;
+                }
+                impl::popRegistry();
+            }
+            bench_report("register 8000 names, hashed at runtime", elapsed[0], count);
+            bench_report("register 8000 names, hashed at compile time", elapsed[1], count);
+
+            // every lookup hashes the name once, so this is the throughput of the hash plus one probe
+            impl::pushRegistry();
+            for (u32 i = 0; i < count; ++i)
+                impl::registerOrGetType(names[i].c_str(), (u32)names[i].size(), hashes[i], type_info_t(), nullptr, 0);
+            u32 const rounds = 100;
+            u32       found  = 0;
+            u64       ns;
+            {
+                bench_timer_t timer;
+                for (u32 r = 0; r < rounds; ++r)
+                {
+                    for (u32 i = 0; i < count; ++i)
+                        found += type_info_t::find(names[i].data(), (u32)names[i].size()).isValid() ? 1 : 0;
+                }
+                ns = timer.elapsed_ns();
+            }
+            CHECK_EQUAL(rounds * count, found);
+            impl::popRegistry();
+            printf("[bench] find by name, %u names of %.1f chars on average: %.0f MB/s\n", count, (double)bytes / count, (double)bytes * rounds * 1000.0 / ns);
+        }
+
+        UNITTEST_TEST(inheritance_footprint)
+        {
+            // 3k types in single inheritance chains of up to 8 levels, every type passes its
+            // flattened list of ancestors just like RTTR_DECLARE_META_TYPE does
+            u32 const                numTypes = 3000;
+            u32 const                maxDepth = 8;
+            std::vector<std::string> names;
+            bench_make_names(names, "footprint", numTypes);
+
+            impl::pushRegistry();
+            registry_stats_t before;
+            getRegistryStats(before);
+
+            std::vector<std::vector<type_info_t> > ancestors(numTypes);
+            for (u32 i = 0; i < numTypes; ++i)
+            {
+                if ((i % maxDepth) != 0)
+                {
+                    ancestors[i].push_back(impl::findType(names[i - 1].c_str()));
+                    ancestors[i].insert(ancestors[i].end(), ancestors[i - 1].begin(), ancestors[i - 1].end());
+                }
+                impl::registerOrGetType(names[i].c_str(), type_info_t(), ancestors[i].empty() ? nullptr : &ancestors[i][0], (int)ancestors[i].size());
+            }
+
+            registry_stats_t after;
+            getRegistryStats(after);
+            u32 const used = after.m_ancestors - before.m_ancestors;
+            CHECK_TRUE(used > 0);
+
+            u64 const rowBytes = (u64)numTypes * 32 * sizeof(type_id_t);                              // former fixed 32-entry row per type
+            u64 const csrBytes = (u64)used * sizeof(type_id_t) + (u64)numTypes * (sizeof(u32) + sizeof(u16));  // ancestors + offset and count per type
+            printf("[bench] inheritance table for %u types: fixed rows %llu bytes, packed %llu bytes (%u ancestors)\n", numTypes, (unsigned long long)rowBytes, (unsigned long long)csrBytes, used);
+            printf("[bench] registry for %u types: %llu bytes allocated\n", numTypes, (unsigned long long)after.m_bytes);
+            impl::popRegistry();
+        }
+
+        UNITTEST_TEST(cache_misses)
+        {
+            // 64k types in chains of 4, every 8th type also has a second base. Before every batch of
+            // queries a buffer twice the size of L2 is read, so the queries find the registry cold.
+            u32 const                numTypes    = 64000;
+            u32 const                numBatches  = 2048;
+            u32 const                batchSize   = 32;
+            u32 const                numQueries  = numBatches * batchSize;
+            u32 const                evictBytes  = 4 * 1024 * 1024;
+            std::vector<std::string> names;
+            bench_make_names(names, "cold", numTypes);
+
+            impl::pushRegistry();
+            std::vector<type_info_t>               types(numTypes);
+            std::vector<std::vector<type_info_t> > ancestors(numTypes);
+            for (u32 i = 0; i < numTypes; ++i)
+            {
+                if ((i % 4) != 0)
+                {
+                    ancestors[i].push_back(types[i - 1]);
+                    ancestors[i].insert(ancestors[i].end(), ancestors[i - 1].begin(), ancestors[i - 1].end());
+                }
+                if ((i % 8) == 7)
+                    ancestors[i].push_back(types[i / 2]);
+                types[i] = impl::registerOrGetType(names[i].c_str(), type_info_t(), ancestors[i].empty() ? nullptr : &ancestors[i][0], (int)ancestors[i].size());
+            }
+
+            // half of the queries ask for an ancestor, the other half for a random type
+            std::vector<type_info_t> from(numQueries), to(numQueries);
+            u32                      seed = 12345;
+            for (u32 q = 0; q < numQueries; ++q)
+            {
+                seed        = seed * 1664525u + 1013904223u;
+                u32 const i = (seed >> 8) % numTypes;
+                seed        = seed * 1664525u + 1013904223u;
+                from[q]     = types[i];
+                to[q]       = ((q & 1) != 0 && !ancestors[i].empty()) ? ancestors[i][(seed >> 8) % ancestors[i].size()] : types[(seed >> 8) % numTypes];
+            }
+
+            std::vector<u64> evict(evictBytes / sizeof(u64), 1);
+            u64              sum = 0;
+            double           castNs = 0.0, rawNs = 0.0;
+            for (u32 batch = 0; batch < numBatches; ++batch)
+            {
+                u32 const first = batch * batchSize;
+                for (u32 i = 0; i < evict.size(); i += 8)
+                    sum += evict[i];
+                {
+                    bench_timer_t timer;
+                    for (u32 q = first; q < first + batchSize; ++q)
+                        sum += from[q].isTypeDerivedFrom(to[q]) ? 1 : 0;
+                    castNs += timer.elapsed_ns();
+                }
+                for (u32 i = 0; i < evict.size(); i += 8)
+                    sum += evict[i];
+                {
+                    bench_timer_t timer;
+                    for (u32 q = first; q < first + batchSize; ++q)
+                        sum += to[q].getRawType().getId();
+                    rawNs += timer.elapsed_ns();
+                }
+            }
+            bench_report("isTypeDerivedFrom, 64k types, cold", castNs, numQueries);
+            bench_report("getRawType, 64k types, cold", rawNs, numQueries);
+
+            registry_stats_t stats;
+            getRegistryStats(stats);
+            printf("[bench] registry of %u types: %llu bytes\n", stats.m_types, (unsigned long long)stats.m_bytes);
+            s_bench_sink = (u32)sum;
+            impl::popRegistry();
+        }
+
+        UNITTEST_TEST(hot_type_profile)
+        {
+            // 64k types in chains of 4, 99% of the types that are queried are 2048 types that are spread
+            // over the registry (and their ancestors). The first run makes a profile of the queries, the
+            // second run loads it before registering, so the hot types get the lowest ids. Like in
+            // cache_misses a buffer twice the size of L2 is read before every batch of queries.
+            u32 const                numTypes   = 64000;
+            u32 const                numHot     = 2048;
+            u32 const                numBatches = 256;
+            u32 const                batchSize  = 4096;
+            u32 const                numQueries = numBatches * batchSize;
+            u32 const                evictBytes = 4 * 1024 * 1024;
+            std::vector<std::string> names;
+            bench_make_names(names, "skewed", numTypes);
+
+            std::vector<std::vector<u32> > ancestors(numTypes);
+            for (u32 i = 0; i < numTypes; ++i)
+            {
+                if ((i % 4) != 0)
+                {
+                    ancestors[i].push_back(i - 1);
+                    ancestors[i].insert(ancestors[i].end(), ancestors[i - 1].begin(), ancestors[i - 1].end());
+                }
+                if ((i % 8) == 7)
+                    ancestors[i].push_back(i / 2);
+            }
+
+            // half of the queries ask for an ancestor, the other half for another type
+            std::vector<u32> fromIndex(numQueries), toIndex(numQueries);
+            u32              seed = 12345;
+            for (u32 q = 0; q < numQueries; ++q)
+            {
+                u32 pick[2];
+                for (u32 p = 0; p < 2; ++p)
+                {
+                    seed           = seed * 1664525u + 1013904223u;
+                    bool const hot = (seed >> 8) % 100 != 0;
+                    seed           = seed * 1664525u + 1013904223u;
+                    pick[p]        = hot ? (((seed >> 8) % numHot) * 31 + 7) % numTypes : (seed >> 8) % numTypes;
+                }
+                fromIndex[q] = pick[0];
+                toIndex[q]   = ((q & 1) != 0 && !ancestors[pick[0]].empty()) ? ancestors[pick[0]][seed % ancestors[pick[0]].size()] : pick[1];
+            }
+
+            std::vector<type_profile_entry_t> profile(2 * numHot);
+            u32                               profileSize = 0;
+            std::vector<u64>                  evict(evictBytes / sizeof(u64), 1);
+            u64                               sum = 0;
+            for (u32 run = 0; run < 2; ++run)
+            {
+                impl::pushRegistry();
+                if (run == 1)
+                    CHECK_TRUE(loadTypeProfile(&profile[0], profileSize));
+
+                std::vector<type_info_t> types(numTypes);
+                std::vector<type_info_t> bases;
+                for (u32 i = 0; i < numTypes; ++i)
+                {
+                    bases.clear();
+                    for (u32 a = 0; a < ancestors[i].size(); ++a)
+                        bases.push_back(types[ancestors[i][a]]);
+                    types[i] = impl::registerOrGetType(names[i].c_str(), type_info_t(), bases.empty() ? nullptr : &bases[0], (int)bases.size());
+                }
+                std::vector<type_info_t> from(numQueries), to(numQueries);
+                for (u32 q = 0; q < numQueries; ++q)
+                {
+                    from[q] = types[fromIndex[q]];
+                    to[q]   = types[toIndex[q]];
+                }
+
+                // what a trace of the first run would have recorded
+                if (run == 0)
+                {
+                    std::vector<trace_event_t> events(numQueries / 8);
+                    for (u32 e = 0; e < events.size(); ++e)
+                    {
+                        events[e].m_op     = TRACE_DERIVED_CHECK;
+                        events[e].m_source = from[e].getId();
+                        events[e].m_target = to[e].getId();
+                    }
+                    profileSize = makeTypeProfile(&events[0], (u32)events.size(), &profile[0], (u32)profile.size());
+                }
+
+                double castNs = 0.0, rawNs = 0.0;
+                for (u32 batch = 0; batch < numBatches; ++batch)
+                {
+                    u32 const first = batch * batchSize;
+                    for (u32 i = 0; i < evict.size(); i += 8)
+                        sum += evict[i];
+                    {
+                        bench_timer_t timer;
+                        for (u32 q = first; q < first + batchSize; ++q)
+                            sum += from[q].isTypeDerivedFrom(to[q]) ? 1 : 0;
+                        castNs += timer.elapsed_ns();
+                    }
+                    for (u32 i = 0; i < evict.size(); i += 8)
+                        sum += evict[i];
+                    {
+                        bench_timer_t timer;
+                        for (u32 q = first; q < first + batchSize; ++q)
+                            sum += to[q].getRawType().getId();
+                        rawNs += timer.elapsed_ns();
+                    }
+                }
+                bench_report(run == 0 ? "isTypeDerivedFrom, skewed, registration order" : "isTypeDerivedFrom, skewed, hot type profile", castNs, numQueries);
+                bench_report(run == 0 ? "getRawType, skewed, registration order" : "getRawType, skewed, hot type profile", rawNs, numQueries);
+                impl::popRegistry();
+            }
+            printf("[bench] profile of %u hot types\n", profileSize);
+            s_bench_sink = (u32)sum;
+        }
+
+        UNITTEST_TEST(readers_during_registration)
+        {
+            u32 const                numWriterTypes = 7000;
+            u32 const                numReaderTypes = 1000;
+            std::vector<std::string> writerNames, readerNames;
+            bench_make_names(writerNames, "writer", numWriterTypes);
+            bench_make_names(readerNames, "reader", numReaderTypes);
+
+            u32 const readerCounts[] = {1, 2, 4};
+            for (u32 c = 0; c < sizeof(readerCounts) / sizeof(readerCounts[0]); ++c)
+            {
+                u32 const numReaders = readerCounts[c];
+
+                impl::pushRegistry();
+                for (u32 i = 0; i < numReaderTypes; ++i)
+                    impl::registerOrGetType(readerNames[i].c_str(), type_info_t(), nullptr, 0);
+
+                std::atomic<bool>        running(true);
+                std::atomic<u32>         started(0);
+                std::atomic<u64>         reads(0);
+                std::atomic<u64>         readNs(0);
+                std::atomic<u32>         misses(0);
+                std::vector<std::thread> readers;
+                for (u32 r = 0; r < numReaders; ++r)
+                {
+                    readers.push_back(std::thread([&, r]() {
+                        u64 count = 0;
+                        u32 i     = r;
+                        started++;
+                        bench_timer_t timer;
+                        while (running.load(std::memory_order_relaxed))
+                        {
+                            type_info_t const info = impl::findType(readerNames[i % numReaderTypes].c_str());
+                            if (!info.isValid() || info.getName() == nullptr || info.getRawType() != info)
+                                misses++;
+                            ++count;
+                            ++i;
+                        }
+                        readNs += (u64)timer.elapsed_ns();
+                        reads += count;
+                    }));
+                }
+
+                while (started.load() != numReaders)
+                    std::this_thread::yield();
+
+                double writer_ns;
+                {
+                    bench_timer_t timer;
+                    for (u32 i = 0; i < numWriterTypes; ++i)
+                        impl::registerOrGetType(writerNames[i].c_str(), type_info_t(), nullptr, 0);
+                    writer_ns = timer.elapsed_ns();
+                }
+                running = false;
+                for (u32 r = 0; r < numReaders; ++r)
+                    readers[r].join();
+
+                CHECK_EQUAL((u32)0, misses.load());
+                printf("[bench] %u reader(s) + 1 writer: writer %8.3f ns/type, readers %8.3f ns/lookup\n", numReaders, writer_ns / (double)numWriterTypes, (double)readNs.load() / (double)reads.load());
+                impl::popRegistry();
+            }
+        }
+    }
+}
+UNITTEST_SUITE_END
@@ -93,3 +93,16 @@ RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(ClassMulti3B)
 RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(ClassMulti4B)
 RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(ClassMulti5B)
 RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(ClassMulti6B)
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(ClassDiamondBase)
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(ClassDiamondLeft)
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(ClassDiamondRight)
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(ClassDiamond)
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(ClassDiamondOther)
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(ClassDiamondTop)
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+RTTR_DEFINE_STANDARD_META_TYPE_VARIANTS(ClassWide)
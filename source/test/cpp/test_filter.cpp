@@ -0,0 +1,159 @@
+#include "crttr/test_classes.h"
+
+#include <vector>
+
+#include "crtti/c_rttr.h"
+#include "cunittest/cunittest.h"
+
+using namespace ncore;
+using namespace ncore::nrtti;
+
+namespace
+{
+    // An object whose type is registered at runtime
+    struct scripted_object_t
+    {
+        type_info_t m_type;
+        type_info_t getTypeInfo() const { return m_type; }
+    };
+}  // namespace
+
+UNITTEST_SUITE_BEGIN(filter)
+{
+    UNITTEST_FIXTURE(rttr_filter)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(derived_type_set)
+        {
+            derived_type_set_t const set(type_info_t::get<ClassSingle3A>());
+            CHECK_TRUE(set.getTarget() == type_info_t::get<ClassSingle3A>());
+            CHECK_TRUE(set.getCount() > type_info_t::get<ClassSingle6A>().getId());
+
+            CHECK_TRUE(set.contains(type_info_t::get<ClassSingle3A>().getId()));
+            CHECK_TRUE(set.contains(type_info_t::get<ClassSingle6A>().getId()));
+            CHECK_TRUE(set.contains(type_info_t::get<ClassSingle6A*>().getId()));
+            CHECK_FALSE(set.contains(type_info_t::get<ClassSingle2A>().getId()));
+            CHECK_FALSE(set.contains(type_info_t::get<ClassSingle6B>().getId()));
+            CHECK_FALSE(set.contains(0));
+        }
+
+        UNITTEST_TEST(filter_pointers)
+        {
+            ClassSingle6A   a6;
+            ClassSingle3A   a3;
+            ClassSingle2A   a2;
+            ClassSingle6B   b6;
+            ClassSingleBase base;
+
+            // more than one block of 64, with NULL pointers in between
+            std::vector<ClassSingleBase*> objects;
+            for (u32 i = 0; i < 50; ++i)
+            {
+                objects.push_back(&a6);
+                objects.push_back(&a2);
+                objects.push_back(NULL);
+                objects.push_back(&b6);
+                objects.push_back(&a3);
+                objects.push_back(&base);
+            }
+
+            std::vector<ClassSingle3A*> out(objects.size());
+            u32 const                   n = rttr_filter<ClassSingle3A*>(&objects[0], (u32)objects.size(), &out[0]);
+            CHECK_EQUAL((u32)100, n);
+
+            u32 mismatches = 0;
+            u32 j          = 0;
+            for (u32 i = 0; i < objects.size(); ++i)
+            {
+                ClassSingle3A* const expected = rttr_cast<ClassSingle3A*>(objects[i]);
+                if (expected != NULL)
+                    mismatches += (out[j++] != expected) ? 1 : 0;
+            }
+            CHECK_EQUAL((u32)0, mismatches);
+            CHECK_TRUE(out[0] == &a6);
+            CHECK_TRUE(out[1] == &a3);
+        }
+
+        UNITTEST_TEST(filter_mask)
+        {
+            ClassMulti7A               multi;
+            ClassMulti3A               other;
+            std::vector<ClassMulti1B*> objects;
+            for (u32 i = 0; i < 70; ++i)
+                objects.push_back((i % 3) == 0 ? (ClassMulti1B*)&multi : (ClassMulti1B*)&other);
+
+            derived_type_set_t const set(type_info_t::get<ClassMulti5B>());
+            u64                      mask[2] = {~(u64)0, ~(u64)0};
+            rttr_filter_mask(set, &objects[0], (u32)objects.size(), mask);
+
+            u32 mismatches = 0;
+            for (u32 i = 0; i < objects.size(); ++i)
+            {
+                bool const expected = (i % 3) == 0;
+                mismatches += (((mask[i >> 6] >> (i & 63)) & 1) != (expected ? 1u : 0u)) ? 1 : 0;
+            }
+            CHECK_EQUAL((u32)0, mismatches);
+            CHECK_EQUAL((u64)0, mask[1] >> (70 - 64));
+        }
+
+        UNITTEST_TEST(types_registered_later)
+        {
+            derived_type_set_t const set(type_info_t::get<ClassDiamondBase>());
+            u32 const                count = set.getCount();
+
+            type_info_t const base[] = {type_info_t::get<ClassDiamondBase>()};
+            type_info_t const later  = impl::registerOrGetType("filter::registered_later", type_info_t(), base, 1);
+            CHECK_TRUE(later.getId() >= count);
+            CHECK_TRUE(set.contains(later.getId()));
+        }
+
+        UNITTEST_TEST(freed_id_taken_by_a_derived_type)
+        {
+            impl::pushRegistry();
+            type_info_t const base  = impl::registerOrGetType("filter::base_t", type_info_t(), nullptr, 0);
+            type_info_t const freed = impl::registerOrGetType("filter::freed_t", type_info_t(), nullptr, 0);
+            type_info_t const other = impl::registerOrGetType("filter::other_t", type_info_t(), nullptr, 0);
+            CHECK_TRUE(unregisterType(freed));
+
+            // the set is built while the id is free, the type that takes it later is derived
+            derived_type_set_t const set(base);
+            type_info_t const        derived = impl::registerOrGetType("filter::derived_t", type_info_t(), &base, 1);
+            CHECK_EQUAL(freed.getId(), derived.getId());
+            CHECK_TRUE(set.getCount() > derived.getId());
+            CHECK_TRUE(set.contains(derived.getId()));
+            CHECK_FALSE(set.contains(other.getId()));
+
+            scripted_object_t const        objects[]  = {{derived}, {other}, {base}};
+            scripted_object_t const *const pointers[] = {&objects[0], &objects[1], &objects[2]};
+            u64                            mask       = ~(u64)0;
+            rttr_filter_mask(set, pointers, 3, &mask);
+            CHECK_EQUAL((u64)5, mask);
+            impl::popRegistry();
+        }
+
+        UNITTEST_TEST(reserved_id_taken_by_a_derived_type)
+        {
+            impl::pushRegistry();
+            type_profile_entry_t const profile[] = {{impl::stableIdOf("filter::hot_t"), 1, 0}};
+            CHECK_TRUE(loadTypeProfile(profile, 1));
+            type_info_t const base = impl::registerOrGetType("filter::base_t", type_info_t(), nullptr, 0);
+
+            // the set is built while the profile still holds the id, the hot type registers after it
+            derived_type_set_t const set(base);
+            type_info_t const        hot = impl::registerOrGetType("filter::hot_t", type_info_t(), &base, 1);
+            CHECK_EQUAL((type_id_t)1, hot.getId());
+            CHECK_TRUE(set.getCount() > hot.getId());
+            CHECK_TRUE(set.contains(hot.getId()));
+
+            scripted_object_t const        objects[]  = {{base}, {hot}};
+            scripted_object_t const *const pointers[] = {&objects[0], &objects[1]};
+            scripted_object_t const       *out[2]     = {nullptr, nullptr};
+            CHECK_EQUAL((u32)2, rttr_filter(set, pointers, 2, out));
+            CHECK_TRUE(out[1] == &objects[1]);
+            impl::popRegistry();
+        }
+    }
+}
+UNITTEST_SUITE_END
@@ -0,0 +1,1420 @@
+#include "crttr/test_classes.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ccore/c_allocator.h"
+#include "crtti/c_rttr.h"
+#include "crtti/impl/c_ancestor_scan.h"
+#include "cunittest/cunittest.h"
+
+using namespace ncore;
+using namespace ncore::nrtti;
+
+namespace
+{
+    // Names for synthetic types, the registry only stores the pointers so they must outlive it
+    static void make_names(std::vector<std::string>& names, const char* prefix, u32 count)
+    {
+        names.resize(count);
+        char buffer[64];
+        for (u32 i = 0; i < count; ++i)
+        {
+            snprintf(buffer, sizeof(buffer), "%s::synthetic_type_%u", prefix, i);
+            names[i] = buffer;
+        }
+    }
+
+    // Names as they come out of the macros for a code base with a lot of templates, every name is
+    // different and names that follow each other differ in a digit or two
+    static void make_corpus(std::vector<std::string>& names, u32 count)
+    {
+        const char* leaves[]    = {"game::component_%u", "ui::widget_%u", "Class%u", "ncore::nrtti::type_%u_t", "render::pass_%u"};
+        const char* templates[] = {"%s", "%s *", "const %s *", "ncore::vector_t<%s>", "ncore::array_t<ncore::pair_t<ncore::string_t, %s>, 16>", "ncore::handle_t<ncore::vector_t<%s, ncore::allocator_t>> *"};
+        u32 const   numLeaves    = sizeof(leaves) / sizeof(leaves[0]);
+        u32 const   numTemplates = sizeof(templates) / sizeof(templates[0]);
+        names.resize(count);
+        char leaf[64], buffer[256];
+        for (u32 i = 0; i < count; ++i)
+        {
+            snprintf(leaf, sizeof(leaf), leaves[i % numLeaves], i / numLeaves);
+            snprintf(buffer, sizeof(buffer), templates[(i / numLeaves) % numTemplates], leaf);
+            names[i] = buffer;
+        }
+    }
+
+    static u32 count_bits(u64 value)
+    {
+        u32 count = 0;
+        for (; value != 0; value &= value - 1)
+            ++count;
+        return count;
+    }
+
+    // Registers a chain of 8 types and then a number of types that derive from two of them
+    static void register_snapshot_types(std::vector<std::string> const& names, std::vector<type_id_t>& ids)
+    {
+        ids.resize(names.size());
+        for (u32 i = 0; i < names.size(); ++i)
+        {
+            type_info_t bases[2];
+            int         numBases = 0;
+            if (i > 0)
+                bases[numBases++] = type_info_t::findByStableId(impl::stableIdOf(names[i < 8 ? i - 1 : i % 8].c_str()));
+            if (i >= 8)
+                bases[numBases++] = type_info_t::findByStableId(impl::stableIdOf(names[(i + 3) % 8].c_str()));
+            ids[i] = impl::registerOrGetType(names[i].c_str(), type_info_t(), bases, numBases).getId();
+        }
+    }
+
+    // Byte offsets of the arrays of a snapshot image, from the 8 words of its header as
+    // saveRegistrySnapshot writes them: magic, version, id size, types, ancestors, index slots, name bytes
+    struct image_layout_t
+    {
+        u64 m_hashes, m_rawTypes, m_ancestorOffsets, m_ancestorCounts, m_depths, m_masks, m_nameOffsets, m_ancestors, m_index, m_names;
+    };
+
+    static u64 align8(u64 offset) { return (offset + 7) & ~(u64)7; }
+
+    static void image_layout(std::vector<u64> const& image, image_layout_t& layout)
+    {
+        u32 const* header        = (u32 const*)&image[0];
+        u64 const  types         = header[3];
+        layout.m_hashes          = 32;
+        layout.m_rawTypes        = align8(layout.m_hashes + types * sizeof(u64));
+        layout.m_ancestorOffsets = align8(layout.m_rawTypes + types * sizeof(type_id_t));
+        layout.m_ancestorCounts  = align8(layout.m_ancestorOffsets + types * sizeof(u32));
+        layout.m_depths          = align8(layout.m_ancestorCounts + types * sizeof(u16));
+        layout.m_masks           = align8(layout.m_depths + types * sizeof(u16));
+        layout.m_nameOffsets     = align8(layout.m_masks + types * sizeof(u32));
+        layout.m_ancestors       = align8(layout.m_nameOffsets + types * sizeof(u32));
+        layout.m_index           = align8(layout.m_ancestors + header[4] * sizeof(type_id_t));
+        layout.m_names           = align8(layout.m_index + header[5] * sizeof(type_id_t));
+    }
+
+    // The snapshot of 100 types, every field of it can be damaged to see that the image is rejected
+    struct damaged_image_t
+    {
+        damaged_image_t()
+        {
+            make_names(m_names, "damaged", 100);
+            impl::pushRegistry();
+            std::vector<type_id_t> ids;
+            register_snapshot_types(m_names, ids);
+            m_size = getRegistrySnapshotSize();
+            m_image.assign((size_t)(m_size + 7) / 8, 0);
+            saveRegistrySnapshot(&m_image[0], m_size);
+            impl::popRegistry();
+            image_layout(m_image, m_layout);
+        }
+
+        u32 header(u32 word) const { return ((u32 const*)&m_image[0])[word]; }
+
+        template <typename T>
+        T* array(u64 offset)
+        {
+            return (T*)((u8*)&m_image[0] + offset);
+        }
+
+        // The damaged image is rejected and leaves the registry empty, so the repaired one loads
+        template <typename T>
+        bool rejects(u64 offset, u32 index, T value)
+        {
+            T* const field = array<T>(offset) + index;
+            T const  good  = *field;
+            *field         = value;
+            impl::pushRegistry();
+            bool const rejected = !loadRegistrySnapshot(&m_image[0], m_size);
+            *field              = good;
+            bool const repaired = loadRegistrySnapshot(&m_image[0], m_size);
+            impl::popRegistry();
+            return rejected && repaired;
+        }
+
+        std::vector<std::string> m_names;  // The image uses the names in place
+        std::vector<u64>         m_image;
+        u64                      m_size;
+        image_layout_t           m_layout;
+    };
+
+    // Counts the blocks it hands out, aligned like the registry asks
+    class counting_alloc_t : public alloc_t
+    {
+    public:
+        counting_alloc_t()
+            : m_allocations(0)
+            , m_live(0)
+        {
+        }
+
+        u32 m_allocations;
+        s32 m_live;
+
+    protected:
+        virtual void* v_allocate(u32 size, u32 alignment)
+        {
+            m_allocations++;
+            m_live++;
+            void*        block   = ::malloc(size + alignment + sizeof(void*));
+            size_t const aligned = ((size_t)block + sizeof(void*) + alignment - 1) & ~(size_t)(alignment - 1);
+            ((void**)aligned)[-1] = block;
+            return (void*)aligned;
+        }
+        virtual void v_deallocate(void* ptr)
+        {
+            m_live--;
+            ::free(((void**)ptr)[-1]);
+        }
+        virtual void v_release() {}
+    };
+}  // namespace
+
+UNITTEST_SUITE_BEGIN(registry)
+{
+    UNITTEST_FIXTURE(threading)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(concurrent_registration)
+        {
+            u32 const                numThreads = 8;
+            u32 const                numTypes   = 4000;
+            std::vector<std::string> names;
+            make_names(names, "concurrent", numTypes);
+
+            impl::pushRegistry();
+
+            // every thread registers all names, each starting at a different offset, while
+            // also reading back the names of the types it got
+            std::vector<std::vector<type_id_t> > ids(numThreads, std::vector<type_id_t>(numTypes, 0));
+            std::atomic<u32>                     badNames(0);
+            std::vector<std::thread>             threads;
+            for (u32 t = 0; t < numThreads; ++t)
+            {
+                threads.push_back(std::thread([&, t]() {
+                    for (u32 n = 0; n < numTypes; ++n)
+                    {
+                        u32 const         i    = (n + t * (numTypes / numThreads)) % numTypes;
+                        type_info_t const info = impl::registerOrGetType(names[i].c_str(), type_info_t(), nullptr, 0);
+                        ids[t][i]              = info.getId();
+                        if (names[i] != info.getName() || info.getRawType() != info)
+                            badNames++;
+                    }
+                }));
+            }
+            for (u32 t = 0; t < numThreads; ++t)
+                threads[t].join();
+
+            CHECK_EQUAL((u32)0, badNames.load());
+
+            // all threads must agree on the id of a name, and every name must have its own id
+            u32                 disagreements = 0;
+            std::vector<u8>     used(65536, 0);
+            u32                 duplicates = 0;
+            for (u32 i = 0; i < numTypes; ++i)
+            {
+                for (u32 t = 1; t < numThreads; ++t)
+                    disagreements += (ids[t][i] != ids[0][i]) ? 1 : 0;
+                duplicates += used[ids[0][i]];
+                used[ids[0][i]] = 1;
+                CHECK_TRUE(ids[0][i] != 0);
+            }
+            CHECK_EQUAL((u32)0, disagreements);
+            CHECK_EQUAL((u32)0, duplicates);
+
+            impl::popRegistry();
+        }
+    }
+
+    UNITTEST_FIXTURE(inheritance)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(diamond_ancestors_are_stored_once)
+        {
+            impl::pushRegistry();
+
+            // Same shape as ClassDiamondTop in test_classes.h; the base class lists are
+            // flattened the way RTTR_DECLARE_META_TYPE passes them.
+            type_info_t const base  = impl::registerOrGetType("Base", type_info_t(), nullptr, 0);
+            type_info_t const lb[]  = {base};
+            type_info_t const left  = impl::registerOrGetType("Left", type_info_t(), lb, 1);
+            type_info_t const right = impl::registerOrGetType("Right", type_info_t(), lb, 1);
+            type_info_t const db[]  = {left, base, right, base};
+            type_info_t const diam  = impl::registerOrGetType("Diamond", type_info_t(), db, 4);
+            type_info_t const other = impl::registerOrGetType("Other", type_info_t(), nullptr, 0);
+
+            registry_stats_t before;
+            getRegistryStats(before);
+            type_info_t const tb[] = {other, diam, left, base, right, base};
+            type_info_t const top  = impl::registerOrGetType("Top", type_info_t(), tb, 6);
+            registry_stats_t after;
+            getRegistryStats(after);
+
+            // Other, Diamond, Left, Right and Base once
+            CHECK_EQUAL((u32)5, after.m_ancestors - before.m_ancestors);
+            CHECK_TRUE(top.isValid());
+
+            impl::popRegistry();
+        }
+
+        UNITTEST_TEST(ancestor_scan_finds_every_position)
+        {
+            type_id_t list[40];
+            for (u32 i = 0; i < 40; ++i)
+                list[i] = (type_id_t)(1000 + i);
+
+            u32 errors = 0;
+            for (u32 count = 0; count <= 40; ++count)
+            {
+                for (u32 i = 0; i < 40; ++i)
+                {
+                    bool const expected = i < count;
+                    errors += (impl::findAncestor(list, count, list[i]) != expected) ? 1 : 0;
+                    errors += (impl::findAncestorScalar(list, count, list[i]) != expected) ? 1 : 0;
+                }
+                errors += impl::findAncestor(list, count, 999) ? 1 : 0;
+            }
+            CHECK_EQUAL((u32)0, errors);
+        }
+
+        UNITTEST_TEST(base_class_lists_are_flattened_at_compile_time)
+        {
+            // Other, Diamond, Left, Base and Right
+            CHECK_EQUAL(5, (int)impl::base_classes<ClassDiamondTop>::count);
+            // 5 chains of 7 classes
+            CHECK_EQUAL(35, (int)impl::base_classes<FinalClass>::count);
+            // 5 chains of 6 classes, their shared ClassSingleBase and ClassDiamondOther
+            CHECK_EQUAL(32, (int)impl::base_classes<ClassWide>::count);
+            CHECK_EQUAL(0, (int)impl::base_classes<ClassSingleBase>::count);
+            CHECK_EQUAL(0, (int)impl::base_classes<ClassWide*>::count);
+
+            ClassWide          wide;
+            ClassDiamondOther* other = &wide;
+            CHECK_TRUE(rttr_cast<ClassWide*>(other) == &wide);
+            CHECK_TRUE(type_info_t::get(*other).isTypeDerivedFrom<ClassSingle3C>());
+            CHECK_TRUE(type_info_t::get<ClassWide>().isTypeDerivedFrom<ClassSingleBase>());
+            CHECK_TRUE(type_info_t::get<ClassWide>().isTypeDerivedFrom<ClassDiamondOther>());
+            CHECK_FALSE(type_info_t::get<ClassWide>().isTypeDerivedFrom<ClassDiamondBase>());
+        }
+    }
+
+    UNITTEST_FIXTURE(stable_id)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(is_the_hash_of_the_name)
+        {
+            static_assert(RTTR_STABLE_ID(ClassSingleBase) == impl::stableIdOf("ClassSingleBase"), "computed at compile time");
+
+            CHECK_TRUE(type_info_t::get<ClassSingleBase>().getStableId() == RTTR_STABLE_ID(ClassSingleBase));
+            // the standard variants are registered as "T *" and "const T *"
+            CHECK_TRUE(type_info_t::get<ClassSingle6A*>().getStableId() == RTTR_STABLE_ID(ClassSingle6A *));
+            CHECK_TRUE(type_info_t::get<const ClassSingle6A*>().getStableId() == RTTR_STABLE_ID(const ClassSingle6A *));
+            CHECK_TRUE(type_info_t::get<ClassSingle6A*>().getStableId() != type_info_t::get<ClassSingle6A>().getStableId());
+            CHECK_TRUE(type_info_t().getStableId() == 0);
+        }
+
+        UNITTEST_TEST(find_by_stable_id)
+        {
+            CHECK_TRUE(type_info_t::findByStableId(RTTR_STABLE_ID(ClassDiamondTop)) == type_info_t::get<ClassDiamondTop>());
+            CHECK_TRUE(type_info_t::findByStableId(type_info_t::get<int>().getStableId()) == type_info_t::get<int>());
+            CHECK_FALSE(type_info_t::findByStableId(impl::stableIdOf("never registered")).isValid());
+            CHECK_FALSE(type_info_t::findByStableId(0).isValid());
+
+            // independent of the registration order
+            u32 const                numTypes = 3000;
+            std::vector<std::string> names;
+            make_names(names, "stable", numTypes);
+
+            std::vector<u64> forward(numTypes);
+            impl::pushRegistry();
+            for (u32 i = 0; i < numTypes; ++i)
+                forward[i] = impl::registerOrGetType(names[i].c_str(), type_info_t(), nullptr, 0).getStableId();
+            impl::popRegistry();
+
+            impl::pushRegistry();
+            u32 mismatches = 0;
+            for (u32 i = numTypes; i-- > 0;)
+            {
+                type_info_t const info = impl::registerOrGetType(names[i].c_str(), type_info_t(), nullptr, 0);
+                mismatches += (info.getStableId() != forward[i]) ? 1 : 0;
+                mismatches += (info.getStableId() != impl::stableIdOf(names[i].c_str())) ? 1 : 0;
+            }
+            for (u32 i = 0; i < numTypes; ++i)
+                mismatches += (type_info_t::findByStableId(forward[i]).getName() != names[i]) ? 1 : 0;
+            CHECK_EQUAL((u32)0, mismatches);
+
+            registry_stats_t stats;
+            getRegistryStats(stats);
+            CHECK_EQUAL((u32)0, stats.m_stable_id_collisions);
+            impl::popRegistry();
+        }
+
+        UNITTEST_TEST(collisions_are_counted)
+        {
+            impl::pushRegistry();
+            type_info_t const first = impl::registerOrGetType("collision::first_t", type_info_t(), nullptr, 0);
+
+            // a second name that is given the stable id of the first
+            const char* const name   = "collision::second_t";
+            type_info_t const second = impl::registerOrGetType(name, (u32)strlen(name), first.getStableId(), type_info_t(), nullptr, 0);
+            CHECK_TRUE(first != second);
+            CHECK_EQUAL(first.getStableId(), second.getStableId());
+            CHECK_EQUAL(0, strcmp(first.getName(), "collision::first_t"));
+            CHECK_EQUAL(0, strcmp(second.getName(), name));
+            CHECK_TRUE(impl::findType("collision::first_t") == first);
+            CHECK_TRUE(type_info_t::findByStableId(first.getStableId()) == first);
+            CHECK_TRUE(impl::registerOrGetType(name, (u32)strlen(name), first.getStableId(), type_info_t(), nullptr, 0) == second);
+
+            registry_stats_t stats;
+            getRegistryStats(stats);
+            CHECK_EQUAL((u32)1, stats.m_stable_id_collisions);
+            impl::popRegistry();
+        }
+    }
+
+    UNITTEST_FIXTURE(find)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(finds_names_that_are_not_terminated)
+        {
+            static_assert(impl::stableIdOf("ClassSingleBase, ClassDiamondTop", 15) == RTTR_STABLE_ID(ClassSingleBase), "only the given length is hashed");
+
+            const char* line = "ClassSingleBase, ClassDiamondTop";
+            CHECK_TRUE(type_info_t::find(line, 15) == type_info_t::get<ClassSingleBase>());
+            CHECK_TRUE(type_info_t::find(line + 17, 15) == type_info_t::get<ClassDiamondTop>());
+            CHECK_FALSE(type_info_t::find(line, 11).isValid());
+            CHECK_FALSE(type_info_t::find(line, 16).isValid());
+            CHECK_FALSE(type_info_t::find(line, 0).isValid());
+        }
+
+        UNITTEST_TEST(name_hash_quality)
+        {
+            u32 const                numTypes = 20000;
+            std::vector<std::string> names;
+            make_corpus(names, numTypes);
+
+            impl::pushRegistry();
+            std::vector<u64> hashes(numTypes);
+            u32              mismatches = 0;
+            for (u32 i = 0; i < numTypes; ++i)
+            {
+                hashes[i] = impl::registerOrGetType(names[i].c_str(), type_info_t(), nullptr, 0).getStableId();
+                mismatches += (hashes[i] != impl::stableIdOf(names[i].c_str(), (u32)names[i].size())) ? 1 : 0;
+            }
+            CHECK_EQUAL((u32)0, mismatches);
+
+            registry_stats_t stats;
+            getRegistryStats(stats);
+            CHECK_EQUAL((u32)0, stats.m_stable_id_collisions);
+            impl::popRegistry();
+
+            // the name index uses the low bits and the sealed index the high bits, both must be close to
+            // uniform: the chi-square of 1024 bins has 1023 degrees of freedom, a standard deviation of 45
+            u32 const buckets = 1024;
+            for (u32 shift = 0; shift <= 54; shift += 54)
+            {
+                std::vector<u32> histogram(buckets, 0);
+                for (u32 i = 0; i < numTypes; ++i)
+                    histogram[(hashes[i] >> shift) & (buckets - 1)]++;
+                double const expected  = (double)numTypes / buckets;
+                double       chiSquare = 0.0;
+                for (u32 b = 0; b < buckets; ++b)
+                    chiSquare += (histogram[b] - expected) * (histogram[b] - expected) / expected;
+                CHECK_TRUE(chiSquare < 1023.0 + 6 * 45.0);
+            }
+
+            // changing the last character flips about half of the bits
+            u64 flipped = 0;
+            for (u32 i = 0; i < 1000; ++i)
+            {
+                std::string name = names[i];
+                name[name.size() - 1] ^= 1;
+                flipped += count_bits(hashes[i] ^ impl::stableIdOf(name.c_str(), (u32)name.size()));
+            }
+            CHECK_TRUE(flipped > 1000 * 28 && flipped < 1000 * 36);
+        }
+
+        UNITTEST_TEST(every_prefix_is_a_different_name)
+        {
+            // all the prefixes of one name, so the length and every tail size of the word hash matter
+            std::string const        full = "ncore::container_t<ncore::pair_t<int, float>, 16>";
+            std::vector<std::string> names;
+            for (u32 length = 1; length <= full.size(); ++length)
+                names.push_back(full.substr(0, length));
+
+            impl::pushRegistry();
+            std::vector<type_id_t> ids;
+            for (u32 i = 0; i < names.size(); ++i)
+                ids.push_back(impl::registerOrGetType(names[i].c_str(), type_info_t(), nullptr, 0).getId());
+
+            for (u32 sealed = 0; sealed < 2; ++sealed)
+            {
+                if (sealed)
+                    CHECK_TRUE(sealRegistry());
+                u32 mismatches = 0;
+                for (u32 i = 0; i < names.size(); ++i)
+                {
+                    mismatches += (type_info_t::find(full.c_str(), i + 1).getId() != ids[i]) ? 1 : 0;
+                    mismatches += (impl::findType(names[i].c_str()).getId() != ids[i]) ? 1 : 0;
+                    mismatches += (type_info_t::find(full.c_str(), i + 1).getStableId() != impl::stableIdOf(names[i].c_str())) ? 1 : 0;
+                }
+                CHECK_EQUAL((u32)0, mismatches);
+            }
+            impl::popRegistry();
+        }
+    }
+
+    UNITTEST_FIXTURE(sealed)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(finds_every_type)
+        {
+            u32 const                numTypes = 5000;
+            std::vector<std::string> names, later;
+            make_names(names, "sealed", numTypes);
+            make_names(later, "later", 10);
+
+            impl::pushRegistry();
+            CHECK_FALSE(sealRegistry());
+
+            std::vector<type_id_t> ids(numTypes);
+            for (u32 i = 0; i < numTypes; ++i)
+                ids[i] = impl::registerOrGetType(names[i].c_str(), type_info_t(), nullptr, 0).getId();
+            CHECK_TRUE(sealRegistry());
+
+            registry_stats_t stats;
+            getRegistryStats(stats);
+            CHECK_EQUAL(numTypes, stats.m_sealed_types);
+
+            u32 mismatches = 0;
+            for (u32 i = 0; i < numTypes; ++i)
+            {
+                mismatches += (impl::findType(names[i].c_str()).getId() != ids[i]) ? 1 : 0;
+                mismatches += (type_info_t::findByStableId(impl::stableIdOf(names[i].c_str())).getId() != ids[i]) ? 1 : 0;
+                mismatches += impl::findType(later[i % 10].c_str()).isValid() ? 1 : 0;
+            }
+            CHECK_EQUAL((u32)0, mismatches);
+
+            // registering after sealing falls back to the regular index
+            for (u32 i = 0; i < 10; ++i)
+                CHECK_EQUAL(numTypes + 1 + i, (u32)impl::registerOrGetType(later[i].c_str(), type_info_t(), nullptr, 0).getId());
+            for (u32 i = 0; i < 10; ++i)
+                mismatches += (impl::findType(later[i].c_str()).getId() != numTypes + 1 + i) ? 1 : 0;
+            mismatches += (impl::findType(names[1234].c_str()).getId() != ids[1234]) ? 1 : 0;
+            CHECK_EQUAL((u32)0, mismatches);
+
+            CHECK_TRUE(sealRegistry());
+            getRegistryStats(stats);
+            CHECK_EQUAL(numTypes + 10, stats.m_sealed_types);
+            CHECK_TRUE(impl::findType(later[9].c_str()).getId() == numTypes + 10);
+            impl::popRegistry();
+        }
+    }
+
+    UNITTEST_FIXTURE(snapshot)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(save_and_load)
+        {
+            std::vector<std::string> names;
+            make_names(names, "snapshot", 1000);
+
+            impl::pushRegistry();
+            std::vector<type_id_t> ids;
+            register_snapshot_types(names, ids);
+            u64 const        size = getRegistrySnapshotSize();
+            std::vector<u64> image((size_t)(size + 7) / 8);
+            CHECK_EQUAL((u64)0, saveRegistrySnapshot(&image[0], size - 8));
+            CHECK_EQUAL(size, saveRegistrySnapshot(&image[0], size));
+            impl::popRegistry();
+
+            impl::pushRegistry();
+            CHECK_TRUE(loadRegistrySnapshot(&image[0], size));
+            CHECK_FALSE(loadRegistrySnapshot(&image[0], size));
+
+            // the types are there before they are registered
+            u32 mismatches = 0;
+            for (u32 i = 0; i < names.size(); ++i)
+                mismatches += (impl::findType(names[i].c_str()).getId() != ids[i]) ? 1 : 0;
+            CHECK_EQUAL((u32)0, mismatches);
+            CHECK_TRUE(impl::findType(names[100].c_str()).isTypeDerivedFrom(impl::findType(names[0].c_str())));
+            CHECK_TRUE(impl::findType(names[7].c_str()).isTypeDerivedFrom(impl::findType(names[2].c_str())));
+            CHECK_FALSE(impl::findType(names[2].c_str()).isTypeDerivedFrom(impl::findType(names[7].c_str())));
+
+            // registering validates and keeps the ids, new types come after the snapshot
+            std::vector<type_id_t> again;
+            register_snapshot_types(names, again);
+            CHECK_TRUE(again == ids);
+            type_info_t const added = impl::registerOrGetType("snapshot::added", type_info_t(), nullptr, 0);
+            CHECK_EQUAL((u32)names.size() + 1, (u32)added.getId());
+
+            registry_stats_t stats;
+            getRegistryStats(stats);
+            CHECK_EQUAL((u32)names.size() + 1, stats.m_snapshot_types);
+            CHECK_EQUAL((u32)0, stats.m_snapshot_mismatches);
+            impl::popRegistry();
+        }
+
+        UNITTEST_TEST(rejects_invalid_images)
+        {
+            impl::pushRegistry();
+            impl::registerOrGetType("snapshot::single", type_info_t(), nullptr, 0);
+            u64 const        size = getRegistrySnapshotSize();
+            std::vector<u64> image((size_t)(size + 7) / 8);
+            CHECK_EQUAL(size, saveRegistrySnapshot(&image[0], size));
+            impl::popRegistry();
+
+            impl::pushRegistry();
+            CHECK_FALSE(loadRegistrySnapshot(&image[0], size - 8));
+            image[0] ^= 1;
+            CHECK_FALSE(loadRegistrySnapshot(&image[0], size));
+            image[0] ^= 1;
+            CHECK_TRUE(loadRegistrySnapshot(&image[0], size));
+            impl::popRegistry();
+        }
+
+        UNITTEST_TEST(types_that_do_not_match_the_snapshot)
+        {
+            impl::pushRegistry();
+            type_info_t const base  = impl::registerOrGetType("snapshot::base_t", type_info_t(), nullptr, 0);
+            type_info_t const other = impl::registerOrGetType("snapshot::other_t", type_info_t(), nullptr, 0);
+            impl::registerOrGetType("snapshot::derived_t", type_info_t(), &base, 1);
+            u64 const        size = getRegistrySnapshotSize();
+            std::vector<u64> image((size_t)(size + 7) / 8);
+            CHECK_EQUAL(size, saveRegistrySnapshot(&image[0], size));
+            impl::popRegistry();
+
+            // a build in which the derived type has another base class
+            impl::pushRegistry();
+            CHECK_TRUE(loadRegistrySnapshot(&image[0], size));
+            type_info_t const loadedBase  = impl::registerOrGetType("snapshot::base_t", type_info_t(), nullptr, 0);
+            type_info_t const loadedOther = impl::registerOrGetType("snapshot::other_t", type_info_t(), nullptr, 0);
+            type_info_t const derived     = impl::registerOrGetType("snapshot::derived_t", type_info_t(), &loadedOther, 1);
+
+            registry_stats_t stats;
+            getRegistryStats(stats);
+            CHECK_EQUAL((u32)1, stats.m_snapshot_mismatches);
+            CHECK_TRUE(derived.isTypeDerivedFrom(loadedBase));
+            CHECK_TRUE(loadedBase == base);
+            CHECK_TRUE(loadedOther == other);
+            impl::popRegistry();
+        }
+    }
+
+    UNITTEST_FIXTURE(damaged_snapshot)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(header_counts)
+        {
+            damaged_image_t image;
+            CHECK_TRUE(image.rejects<u32>(0, 3, 0xFFFFFFFF));  // types
+            CHECK_TRUE(image.rejects<u32>(0, 4, 0xFFFFFFFF));  // ancestors
+            CHECK_TRUE(image.rejects<u32>(0, 5, 0x80000000));  // index slots
+            CHECK_TRUE(image.rejects<u32>(0, 6, 0xFFFFFFF0));  // name bytes
+            CHECK_TRUE(image.rejects<u32>(0, 6, image.header(6) - 1));
+        }
+
+        UNITTEST_TEST(name_offsets)
+        {
+            damaged_image_t image;
+            u32 const       offset2 = image.array<u32>(image.m_layout.m_nameOffsets)[2];
+            u32 const       offset4 = image.array<u32>(image.m_layout.m_nameOffsets)[4];
+            u32 const       offset5 = image.array<u32>(image.m_layout.m_nameOffsets)[5];
+            CHECK_TRUE(image.rejects<u32>(image.m_layout.m_nameOffsets, 99, image.header(6) + 8));  // past the names
+            CHECK_TRUE(image.rejects<u32>(image.m_layout.m_nameOffsets, 3, offset2));               // empty name
+            CHECK_TRUE(image.rejects<u32>(image.m_layout.m_nameOffsets, 3, offset5));               // goes back
+            CHECK_TRUE(image.rejects<char>(image.m_layout.m_names, offset4 - 1, 'x'));              // not terminated
+        }
+
+        UNITTEST_TEST(type_ids)
+        {
+            damaged_image_t image;
+            type_id_t const types = (type_id_t)image.header(3);
+            CHECK_TRUE(image.rejects<u64>(image.m_layout.m_hashes, 7, 0));
+            CHECK_TRUE(image.rejects<type_id_t>(image.m_layout.m_rawTypes, 7, types));
+            CHECK_TRUE(image.rejects<type_id_t>(image.m_layout.m_rawTypes, 7, 0));
+            CHECK_TRUE(image.rejects<type_id_t>(image.m_layout.m_ancestors, 0, types));
+
+            type_id_t* const index = image.array<type_id_t>(image.m_layout.m_index);
+            u32              slot  = 0;
+            while (index[slot] == 0)
+                ++slot;
+            CHECK_TRUE(image.rejects<type_id_t>(image.m_layout.m_index, slot, types));
+
+            // a type in every slot of the index leaves no empty slot to end a probe
+            for (u32 i = 0; i < image.header(5); ++i)
+                index[i] = 1;
+            impl::pushRegistry();
+            CHECK_FALSE(loadRegistrySnapshot(&image.m_image[0], image.m_size));
+            impl::popRegistry();
+        }
+
+        UNITTEST_TEST(ancestor_spans)
+        {
+            damaged_image_t image;
+            u32 const       ancestors = image.header(4);
+            u16 const       count     = image.array<u16>(image.m_layout.m_ancestorCounts)[99];
+            CHECK_TRUE(count > 0);
+            CHECK_TRUE(image.rejects<u32>(image.m_layout.m_ancestorOffsets, 99, ancestors - count + 1));
+            CHECK_TRUE(image.rejects<u32>(image.m_layout.m_ancestorOffsets, 99, 0xFFFFFFFF));
+            CHECK_TRUE(image.rejects<u16>(image.m_layout.m_ancestorCounts, 99, 0xFFFF));
+            CHECK_TRUE(image.rejects<u16>(image.m_layout.m_depths, 99, (u16)(count + 1)));
+        }
+    }
+
+    UNITTEST_FIXTURE(cast_cache)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(repeated_casts_hit)
+        {
+            FinalClass        object;
+            type_info_t const info = type_info_t::get(object);
+
+            resetCastCacheStats();
+            u32 found = 0;
+            for (u32 i = 0; i < 100; ++i)
+            {
+                found += info.isTypeDerivedFrom<ClassMultiple3E>() ? 1 : 0;
+                found += info.isTypeDerivedFrom<ClassSingle6A>() ? 1 : 0;
+            }
+            CHECK_EQUAL((u32)100, found);
+
+            cast_cache_stats_t stats;
+            getCastCacheStats(stats);
+#if RTTR_ENABLE_CAST_CACHE
+            CHECK_EQUAL((u64)2, stats.m_misses);
+            CHECK_EQUAL((u64)198, stats.m_hits);
+#else
+            CHECK_EQUAL((u64)0, stats.m_misses);
+            CHECK_EQUAL((u64)0, stats.m_hits);
+#endif
+        }
+
+        UNITTEST_TEST(registration_invalidates)
+        {
+            // the same ids get a different meaning in the second registry
+            impl::pushRegistry();
+            type_info_t const a    = impl::registerOrGetType("A", type_info_t(), nullptr, 0);
+            type_info_t const ab[] = {a};
+            type_info_t const b    = impl::registerOrGetType("B", type_info_t(), ab, 1);
+            CHECK_TRUE(b.isTypeDerivedFrom(a));
+            CHECK_TRUE(b.isTypeDerivedFrom(a));
+            impl::popRegistry();
+
+            impl::pushRegistry();
+            type_info_t const c = impl::registerOrGetType("A", type_info_t(), nullptr, 0);
+            type_info_t const d = impl::registerOrGetType("D", type_info_t(), nullptr, 0);
+            CHECK_EQUAL(a.getId(), c.getId());
+            CHECK_EQUAL(b.getId(), d.getId());
+            CHECK_FALSE(d.isTypeDerivedFrom(c));
+
+            type_info_t const eb[] = {d};
+            type_info_t const e    = impl::registerOrGetType("E", type_info_t(), eb, 1);
+            CHECK_TRUE(e.isTypeDerivedFrom(d));
+            CHECK_FALSE(d.isTypeDerivedFrom(e));
+            impl::popRegistry();
+        }
+    }
+
+    UNITTEST_FIXTURE(counters)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(count_registrations_lookups_and_casts)
+        {
+            // one of the objects is a ClassSingle6A, the casts are done once so all types are registered before counting
+            ClassSingle6A        six;
+            ClassSingle3A        three;
+            ClassSingle1A* const objects[] = {&six, &three};
+            for (u32 i = 0; i < 2; ++i)
+                rttr_cast<ClassSingle6A*>(objects[i]);
+
+            u32 const                numTypes = 40;
+            std::vector<std::string> names;
+            make_names(names, "counted", numTypes);
+
+            resetRegistryCounters();
+            impl::pushRegistry();
+            type_info_t const root = impl::registerOrGetType(names[0].c_str(), type_info_t(), nullptr, 0);
+            for (u32 i = 1; i < numTypes; ++i)
+                impl::registerOrGetType(names[i].c_str(), type_info_t(), &root, 1);
+            impl::registerOrGetType(names[0].c_str(), type_info_t(), nullptr, 0);
+            CHECK_TRUE(impl::findType(names[1].c_str()).isTypeDerivedFrom(root));
+            CHECK_FALSE(impl::findType("counted::missing").isValid());
+
+            // the counts of a thread that has exited are kept
+            std::thread lookups([&names]() {
+                for (u32 i = 0; i < 10; ++i)
+                    impl::findType(names[i].c_str());
+            });
+            lookups.join();
+            impl::popRegistry();
+
+            u32 casts = 0;
+            for (u32 i = 0; i < 2; ++i)
+                casts += rttr_cast<ClassSingle6A*>(objects[i]) != NULL ? 1 : 0;
+            CHECK_EQUAL((u32)1, casts);
+
+            registry_counters_t counters;
+            getRegistryCounters(counters);
+#if RTTR_ENABLE_STATS
+            CHECK_EQUAL((u64)numTypes + 1, counters.m_registrations);
+            CHECK_EQUAL((u64)numTypes, counters.m_inserted_types);
+            CHECK_EQUAL((u64)12, counters.m_lookups);
+            CHECK_EQUAL((u64)1, counters.m_lookup_misses);
+            CHECK_TRUE(counters.m_index_rebuilds >= 1);
+            CHECK_EQUAL((u64)3, counters.m_derived_checks);
+            CHECK_EQUAL((u64)2, counters.m_casts);
+            CHECK_EQUAL((u64)1, counters.m_failed_casts);
+            CHECK_EQUAL(counters.m_registrations, counters.m_registration.m_calls);
+            CHECK_EQUAL(counters.m_lookups, counters.m_lookup.m_calls);
+            CHECK_EQUAL(counters.m_index_rebuilds, counters.m_index_rebuild.m_calls);
+            CHECK_EQUAL(counters.m_derived_checks, counters.m_derived_check.m_calls);
+            CHECK_EQUAL(counters.m_casts, counters.m_cast.m_calls);
+
+            u64 bucketed = 0;
+            for (u32 b = 0; b < RTTR_STATS_HISTOGRAM_SIZE; ++b)
+                bucketed += counters.m_lookup.m_buckets[b];
+            CHECK_EQUAL(counters.m_lookup.m_calls, bucketed);
+
+            resetRegistryCounters();
+            getRegistryCounters(counters);
+            CHECK_EQUAL((u64)0, counters.m_lookups);
+            CHECK_EQUAL((u64)0, counters.m_lookup.m_calls);
+#else
+            u64 const* values = (u64 const*)&counters;
+            u32        nonZero = 0;
+            for (u32 i = 0; i < sizeof(counters) / sizeof(u64); ++i)
+                nonZero += values[i] != 0 ? 1 : 0;
+            CHECK_EQUAL((u32)0, nonZero);
+#endif
+        }
+    }
+
+    UNITTEST_FIXTURE(trace)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(records_registrations_checks_and_casts)
+        {
+            // the casts are done once so all types are registered before recording
+            ClassSingle6A        six;
+            ClassSingle3A        three;
+            ClassSingle1A* const objects[] = {&six, &three};
+            for (u32 i = 0; i < 2; ++i)
+                rttr_cast<ClassSingle6A*>(objects[i]);
+
+            std::vector<trace_event_t> events(RTTR_TRACE_BUFFER_SIZE + 256);
+            while (drainTraceEvents(&events[0], (u32)events.size()) != 0)
+            {
+            }
+
+            setTraceEnabled(true);
+            impl::pushRegistry();
+            type_info_t const a    = impl::registerOrGetType("A", type_info_t(), nullptr, 0);
+            type_info_t const ab[] = {a};
+            type_info_t const b    = impl::registerOrGetType("B", type_info_t(), ab, 1);
+            impl::registerOrGetType("A", type_info_t(), nullptr, 0);
+            CHECK_TRUE(b.isTypeDerivedFrom(a));
+
+            // the events of a thread that has exited are kept until they are drained
+            std::thread worker([&a, &b]() { a.isTypeDerivedFrom(b); });
+            worker.join();
+            impl::popRegistry();
+
+            for (u32 i = 0; i < 2; ++i)
+                rttr_cast<ClassSingle6A*>(objects[i]);
+            setTraceEnabled(false);
+            rttr_cast<ClassSingle6A*>(objects[0]);
+
+            u32 const count = drainTraceEvents(&events[0], (u32)events.size());
+#if RTTR_ENABLE_TRACE
+            CHECK_EQUAL((u32)9, count);
+
+            // the events of this thread (the only one that registered), in the order they were recorded
+            u16 thread = 0;
+            for (u32 i = 0; i < count; ++i)
+            {
+                if (events[i].m_op == TRACE_REGISTER)
+                    thread = events[i].m_thread;
+            }
+            std::vector<trace_event_t> mine;
+            for (u32 i = 0; i < count; ++i)
+            {
+                if (events[i].m_thread == thread)
+                    mine.push_back(events[i]);
+            }
+            CHECK_EQUAL((size_t)8, mine.size());
+
+            u8 const        ops[]     = {TRACE_REGISTER, TRACE_REGISTER, TRACE_REGISTER, TRACE_DERIVED_CHECK, TRACE_DERIVED_CHECK, TRACE_CAST, TRACE_DERIVED_CHECK, TRACE_CAST};
+            type_id_t const sources[] = {a.getId(), b.getId(), a.getId(), b.getId(), six.getTypeInfo().getId(), six.getTypeInfo().getId(), three.getTypeInfo().getId(), three.getTypeInfo().getId()};
+            u8 const        results[] = {1, 1, 0, 1, 1, 1, 0, 0};
+            u32             wrong     = 0;
+            for (u32 i = 0; i < 8 && i < mine.size(); ++i)
+            {
+                wrong += (mine[i].m_op != ops[i] || mine[i].m_source != sources[i] || mine[i].m_result != results[i]) ? 1 : 0;
+                wrong += (i > 0 && mine[i].m_time_ns < mine[i - 1].m_time_ns) ? 1 : 0;
+            }
+            CHECK_EQUAL((u32)0, wrong);
+            CHECK_EQUAL(impl::metatype_info_t<ClassSingle6A*>::getTypeInfo().getId(), mine[7].m_target);
+            CHECK_EQUAL(mine[6].m_target, mine[7].m_target);
+
+            // a full ring keeps the newest events
+            setTraceEnabled(true);
+            for (u32 i = 0; i < RTTR_TRACE_BUFFER_SIZE + 100; ++i)
+                rttr_cast<ClassSingle6A*>(objects[i & 1]);
+            setTraceEnabled(false);
+            CHECK_EQUAL((u32)RTTR_TRACE_BUFFER_SIZE, drainTraceEvents(&events[0], (u32)events.size()));
+            CHECK_EQUAL((u8)TRACE_CAST, events[RTTR_TRACE_BUFFER_SIZE - 1].m_op);
+
+            // a csv file gets a header and a line per event, with the names of the types
+            setTraceEnabled(true);
+            rttr_cast<ClassSingle6A*>(objects[1]);
+            setTraceEnabled(false);
+            const char* path = "crtti_trace_test.csv";
+            remove(path);
+            CHECK_TRUE(drainTraceToFile(path, TRACE_FORMAT_CSV));
+            FILE* file = fopen(path, "r");
+            CHECK_TRUE(file != NULL);
+            char line[512];
+            u32  lines = 0, casts = 0;
+            while (file != NULL && fgets(line, sizeof(line), file) != NULL)
+            {
+                lines++;
+                casts += (strstr(line, ",cast,") != NULL && strstr(line, "ClassSingle3A") != NULL && strstr(line, "ClassSingle6A") != NULL) ? 1 : 0;
+            }
+            if (file != NULL)
+                fclose(file);
+            remove(path);
+            CHECK_EQUAL((u32)3, lines);
+            CHECK_EQUAL((u32)1, casts);
+#else
+            CHECK_EQUAL((u32)0, count);
+            CHECK_FALSE(drainTraceToFile("crtti_trace_test.csv", TRACE_FORMAT_CSV));
+#endif
+        }
+    }
+
+    UNITTEST_FIXTURE(profile)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(hot_types_get_the_lowest_ids)
+        {
+            std::vector<std::string> names;
+            make_names(names, "profiled", 1000);
+            u32 const hot[]   = {997, 500, 9, 123, 3};
+            u32 const numHot  = sizeof(hot) / sizeof(hot[0]);
+            u32 const numRows = 64;
+
+            // a recorded run, type hot[h] takes part in numHot - h events
+            impl::pushRegistry();
+            std::vector<type_id_t> ids;
+            register_snapshot_types(names, ids);
+            std::vector<trace_event_t> events;
+            for (u32 h = 0; h < numHot; ++h)
+            {
+                for (u32 e = h; e < numHot; ++e)
+                {
+                    trace_event_t event = {};
+                    event.m_op          = TRACE_DERIVED_CHECK;
+                    event.m_source      = ids[hot[h]];
+                    events.push_back(event);
+                }
+            }
+            type_profile_entry_t entries[8];
+            CHECK_EQUAL(numHot, makeTypeProfile(&events[0], (u32)events.size(), entries, 8));
+            CHECK_EQUAL((u32)2, makeTypeProfile(&events[0], (u32)events.size(), entries, 2));
+            CHECK_EQUAL(numHot, makeTypeProfile(&events[0], (u32)events.size(), entries, 8));
+            for (u32 h = 0; h < numHot; ++h)
+            {
+                CHECK_EQUAL(impl::stableIdOf(names[hot[h]].c_str()), entries[h].m_stableId);
+                CHECK_EQUAL(numHot - h, entries[h].m_uses);
+            }
+            CHECK_EQUAL((u32)3, entries[numHot - 1].m_ancestors);  // 2, 1 and 0
+            CHECK_EQUAL((u32)3, entries[2].m_ancestors);           // 1, 0 and 4
+
+            std::vector<bool> derived;
+            for (u32 i = 0; i < numRows; ++i)
+                for (u32 h = 0; h < numHot; ++h)
+                    derived.push_back(impl::findType(names[hot[h]].c_str()).isTypeDerivedFrom(impl::findType(names[i].c_str())));
+            impl::popRegistry();
+
+            // the next run registers in the same order, the hot types get ids 1 to numHot
+            impl::pushRegistry();
+            CHECK_TRUE(loadTypeProfile(entries, numHot));
+            CHECK_FALSE(loadTypeProfile(entries, numHot));
+            registry_stats_t stats;
+            getRegistryStats(stats);
+            CHECK_EQUAL(numHot, stats.m_reserved_types);
+            CHECK_FALSE(impl::findType(names[hot[0]].c_str()).isValid());
+
+            std::vector<type_id_t> profiled;
+            register_snapshot_types(names, profiled);
+            u32 mismatches = 0;
+            for (u32 h = 0; h < numHot; ++h)
+                mismatches += (profiled[hot[h]] != h + 1) ? 1 : 0;
+            for (u32 i = 0; i < names.size(); ++i)
+            {
+                mismatches += (impl::findType(names[i].c_str()).getId() != profiled[i]) ? 1 : 0;
+                mismatches += (type_info_t::findByStableId(impl::stableIdOf(names[i].c_str())).getId() != profiled[i]) ? 1 : 0;
+            }
+            CHECK_EQUAL((u32)0, mismatches);
+
+            // the same answers as without the profile
+            u32 r = 0;
+            for (u32 i = 0; i < numRows; ++i)
+                for (u32 h = 0; h < numHot; ++h)
+                    mismatches += (impl::findType(names[hot[h]].c_str()).isTypeDerivedFrom(impl::findType(names[i].c_str())) != derived[r++]) ? 1 : 0;
+            CHECK_EQUAL((u32)0, mismatches);
+
+            getRegistryStats(stats);
+            CHECK_EQUAL((u32)0, stats.m_reserved_types);
+            CHECK_EQUAL((u32)names.size() + 1, stats.m_types);
+            u64 const        size = getRegistrySnapshotSize();
+            std::vector<u64> image((size_t)(size + 7) / 8);
+            CHECK_EQUAL(size, saveRegistrySnapshot(&image[0], size));
+            impl::popRegistry();
+        }
+
+        UNITTEST_TEST(types_that_do_not_match_the_profile)
+        {
+            impl::pushRegistry();
+            type_profile_entry_t entries[3] = {{impl::stableIdOf("profile::derived"), 0, 3}, {impl::stableIdOf("profile::missing"), 1, 2}, {impl::stableIdOf("profile::base"), 0, 1}};
+            type_profile_entry_t invalid[2] = {entries[0], entries[0]};
+            CHECK_FALSE(loadTypeProfile(invalid, 2));
+            invalid[1].m_stableId = 0;
+            CHECK_FALSE(loadTypeProfile(invalid, 2));
+            CHECK_TRUE(loadTypeProfile(entries, 3));
+
+            // the derived type has more ancestors than its reserved span, it keeps its id
+            type_info_t const other   = impl::registerOrGetType("profile::other", type_info_t(), nullptr, 0);
+            type_info_t const base    = impl::registerOrGetType("profile::base", type_info_t(), nullptr, 0);
+            type_info_t const derived = impl::registerOrGetType("profile::derived", type_info_t(), &base, 1);
+            CHECK_EQUAL((u32)4, (u32)other.getId());
+            CHECK_EQUAL((u32)3, (u32)base.getId());
+            CHECK_EQUAL((u32)1, (u32)derived.getId());
+            CHECK_TRUE(derived.isTypeDerivedFrom(base));
+            CHECK_FALSE(base.isTypeDerivedFrom(derived));
+            CHECK_FALSE(derived.isTypeDerivedFrom(other));
+
+            // the id of a type that is never registered stays empty
+            registry_stats_t stats;
+            getRegistryStats(stats);
+            CHECK_EQUAL((u32)1, stats.m_reserved_types);
+            CHECK_FALSE(impl::findType("profile::missing").isValid());
+            CHECK_FALSE(type_info_t::findByStableId(impl::stableIdOf("profile::missing")).isValid());
+            u64 const        size = getRegistrySnapshotSize();
+            std::vector<u64> image((size_t)(size + 7) / 8);
+            CHECK_EQUAL((u64)0, saveRegistrySnapshot(&image[0], size));
+            derived_type_set_t const set(base);
+            CHECK_TRUE(set.contains(derived.getId()));
+            CHECK_FALSE(set.contains(2));
+            CHECK_TRUE(sealRegistry());
+            CHECK_EQUAL((u32)3, (u32)impl::findType("profile::base").getId());
+            impl::popRegistry();
+
+            impl::pushRegistry();
+            impl::registerOrGetType("profile::early", type_info_t(), nullptr, 0);
+            CHECK_FALSE(loadTypeProfile(entries, 3));
+            impl::popRegistry();
+        }
+    }
+
+    UNITTEST_FIXTURE(name_arena)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(owns_dynamic_names)
+        {
+            impl::pushRegistry();
+            registry_stats_t empty;
+            getRegistryStats(empty);
+            CHECK_EQUAL((u64)0, empty.m_name_arena_bytes);
+
+            // literals are not copied
+            const char*       literal = "arena::literal_t";
+            type_info_t const base    = impl::registerOrGetType(literal, type_info_t(), nullptr, 0);
+            CHECK_TRUE(base.getName() == literal);
+
+            // the buffer is reused for every name, and the names are not terminated
+            u32 const numTypes = 2000;
+            char      buffer[64];
+            std::vector<type_id_t> ids(numTypes);
+            for (u32 i = 0; i < numTypes; ++i)
+            {
+                int const length = snprintf(buffer, sizeof(buffer), "plugin::scripted_type_%u;", i);
+                ids[i]           = impl::registerOrGetDynamicType(buffer, (u32)length - 1, type_info_t(), &base, 1).getId();
+            }
+
+            u32 mismatches = 0;
+            for (u32 i = 0; i < numTypes; ++i)
+            {
+                snprintf(buffer, sizeof(buffer), "plugin::scripted_type_%u", i);
+                type_info_t const info = impl::findType(buffer);
+                mismatches += (info.getId() != ids[i] || strcmp(info.getName(), buffer) != 0) ? 1 : 0;
+                mismatches += info.isTypeDerivedFrom(base) ? 0 : 1;
+            }
+            CHECK_EQUAL((u32)0, mismatches);
+
+            // names registered one after the other sit next to each other
+            const char* first  = impl::findType("plugin::scripted_type_0").getName();
+            const char* second = impl::findType("plugin::scripted_type_1").getName();
+            CHECK_TRUE(second == first + strlen(first) + 1);
+
+            // registering an existing name copies nothing
+            registry_stats_t before, after;
+            getRegistryStats(before);
+            CHECK_TRUE(before.m_name_arena_bytes > 0);
+            CHECK_TRUE(impl::registerOrGetDynamicType("arena::literal_t", 16, type_info_t(), nullptr, 0) == base);
+            getRegistryStats(after);
+            CHECK_EQUAL(before.m_name_arena_bytes, after.m_name_arena_bytes);
+            CHECK_EQUAL(before.m_types, after.m_types);
+            impl::popRegistry();
+        }
+    }
+
+    UNITTEST_FIXTURE(unregister)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(module_load_and_unload)
+        {
+            impl::pushRegistry();
+            type_info_t const host = impl::registerOrGetType("host::base_t", type_info_t(), nullptr, 0);
+
+            // a synthetic module: a chain of two types, a pointer variant and a type with a runtime name
+            type_info_t      types[4];
+            type_info_t      firstLoad[4];
+            registry_stats_t loaded, unloaded;
+            u32              failures = 0;
+            for (u32 cycle = 0; cycle < 10000; ++cycle)
+            {
+                types[0] = impl::registerOrGetType("plugin::a_t", type_info_t(), &host, 1);
+                type_info_t const aBases[] = {types[0], host};
+                types[1] = impl::registerOrGetType("plugin::b_t", type_info_t(), aBases, 2);
+                types[2] = impl::registerOrGetType("plugin::b_t *", types[1], nullptr, 0);
+                char name[32];
+                int const length = snprintf(name, sizeof(name), "plugin::scripted_t");
+                type_info_t const bBases[] = {types[1], types[0], host};
+                types[3] = impl::registerOrGetDynamicType(name, (u32)length, type_info_t(), bBases, 3);
+
+                failures += types[3].isTypeDerivedFrom(host) && types[3].isTypeDerivedFrom(types[0]) ? 0 : 1;
+                failures += types[2].getRawType() == types[1] ? 0 : 1;
+                failures += impl::findType("plugin::scripted_t") == types[3] ? 0 : 1;
+                if (cycle == 0)
+                {
+                    for (u32 i = 0; i < 4; ++i)
+                        firstLoad[i] = types[i];
+                    getRegistryStats(loaded);
+
+                    // the derived types and the pointer variant still depend on these
+                    CHECK_FALSE(unregisterType(types[0]));
+                    CHECK_FALSE(unregisterType(types[1]));
+                    CHECK_FALSE(unregisterType(host));
+                }
+
+                for (u32 i = 4; i-- > 0;)
+                    failures += unregisterType(types[i]) ? 0 : 1;
+                failures += impl::findType("plugin::a_t").isValid() ? 1 : 0;
+                failures += type_info_t::findByStableId(RTTR_STABLE_ID(plugin::a_t)).isValid() ? 1 : 0;
+                if (cycle == 0)
+                    getRegistryStats(unloaded);
+            }
+            CHECK_EQUAL((u32)0, failures);
+
+            // the module was loaded again and again in the same memory and with the same ids
+            registry_stats_t last;
+            getRegistryStats(last);
+            CHECK_EQUAL(unloaded.m_types, last.m_types);
+            CHECK_EQUAL(unloaded.m_index_size, last.m_index_size);
+            CHECK_EQUAL(unloaded.m_ancestors, last.m_ancestors);
+            CHECK_EQUAL(unloaded.m_name_arena_bytes, last.m_name_arena_bytes);
+            CHECK_EQUAL(unloaded.m_bytes, last.m_bytes);
+            CHECK_EQUAL((u32)4, last.m_free_types);
+            CHECK_EQUAL(loaded.m_types, last.m_types);
+
+            // the type_info_t of the first load is stale, even though the ids were reused
+            type_info_t const reloaded = impl::registerOrGetType("plugin::a_t", type_info_t(), &host, 1);
+            CHECK_EQUAL(firstLoad[0].getId(), reloaded.getId());
+            CHECK_FALSE(firstLoad[0].isRegistered());
+            CHECK_TRUE(reloaded.isRegistered());
+            CHECK_TRUE(firstLoad[0] != reloaded);
+            CHECK_EQUAL(0, strcmp(firstLoad[0].getName(), "Invalid type_info_t"));
+            CHECK_FALSE(firstLoad[1].getRawType().isValid());
+            CHECK_TRUE(reloaded.isTypeDerivedFrom(host));
+            CHECK_FALSE(firstLoad[0].isTypeDerivedFrom(host));
+            CHECK_FALSE(reloaded.isTypeDerivedFrom(firstLoad[0]));
+            CHECK_FALSE(unregisterType(firstLoad[0]));
+            CHECK_TRUE(host.isRegistered());
+            impl::popRegistry();
+        }
+
+        UNITTEST_TEST(other_types_are_still_found)
+        {
+            u32 const                numTypes = 3000;
+            std::vector<std::string> names;
+            make_names(names, "tombstone", numTypes);
+
+            impl::pushRegistry();
+            std::vector<type_info_t> infos(numTypes);
+            for (u32 i = 0; i < numTypes; ++i)
+                infos[i] = impl::registerOrGetType(names[i].c_str(), type_info_t(), nullptr, 0);
+            CHECK_TRUE(sealRegistry());
+
+            // every third type leaves a tombstone in the probe sequences of the others
+            for (u32 i = 0; i < numTypes; i += 3)
+                CHECK_TRUE(unregisterType(infos[i]));
+
+            registry_stats_t stats;
+            getRegistryStats(stats);
+            CHECK_EQUAL((u32)0, stats.m_sealed_types);
+            CHECK_EQUAL((u32)1000, stats.m_free_types);
+            u64 const        size = getRegistrySnapshotSize();
+            std::vector<u64> image((size_t)(size + 7) / 8);
+            CHECK_EQUAL((u64)0, saveRegistrySnapshot(&image[0], size));
+
+            u32 mismatches = 0;
+            for (u32 i = 0; i < numTypes; ++i)
+            {
+                type_info_t const found = impl::findType(names[i].c_str());
+                mismatches += (found == ((i % 3) == 0 ? type_info_t() : infos[i])) ? 0 : 1;
+            }
+            CHECK_EQUAL((u32)0, mismatches);
+
+            // new types take the free ids and the tombstones
+            std::vector<std::string> later;
+            make_names(later, "reused", 1000);
+            for (u32 i = 0; i < 1000; ++i)
+                mismatches += (impl::registerOrGetType(later[i].c_str(), type_info_t(), nullptr, 0).getId() % 3 == 1) ? 0 : 1;
+            for (u32 i = 0; i < numTypes; ++i)
+                mismatches += ((i % 3) == 0 || impl::findType(names[i].c_str()) == infos[i]) ? 0 : 1;
+            for (u32 i = 0; i < 1000; ++i)
+                mismatches += impl::findType(later[i].c_str()).isRegistered() ? 0 : 1;
+            CHECK_EQUAL((u32)0, mismatches);
+
+            registry_stats_t reused;
+            getRegistryStats(reused);
+            CHECK_EQUAL(stats.m_types, reused.m_types);
+            CHECK_EQUAL((u32)0, reused.m_free_types);
+            impl::popRegistry();
+        }
+
+        UNITTEST_TEST(lookups_while_a_module_is_reloaded)
+        {
+            u32 const                numThreads = 3;
+            u32 const                numStable  = 500;
+            u32 const                numModule  = 200;
+            std::vector<std::string> stable, module;
+            make_names(stable, "resident", numStable);
+            make_names(module, "reloaded", numModule);
+
+            impl::pushRegistry();
+            std::vector<type_info_t> infos(numStable);
+            for (u32 i = 0; i < numStable; ++i)
+                infos[i] = impl::registerOrGetType(stable[i].c_str(), type_info_t(), nullptr, 0);
+
+            // the module registers in a different order every cycle, its types take each others ids
+            // and tombstones, with their names copied into the arena and given back on unload
+            std::atomic<bool> done(false);
+            std::atomic<u32>  failures(0);
+            std::thread       loader([&]() {
+                type_info_t types[numModule];
+                for (u32 cycle = 0; cycle < 300; ++cycle)
+                {
+                    for (u32 n = 0; n < numModule; ++n)
+                    {
+                        u32 const i = (n * 7 + cycle) % numModule;
+                        types[n]    = impl::registerOrGetDynamicType(module[i].c_str(), (u32)module[i].size(), type_info_t(), nullptr, 0);
+                    }
+                    for (u32 n = numModule; n-- > 0;)
+                        failures += unregisterType(types[n]) ? 0 : 1;
+                }
+                done = true;
+            });
+
+            std::vector<std::thread> readers;
+            for (u32 t = 0; t < numThreads; ++t)
+            {
+                readers.push_back(std::thread([&, t]() {
+                    for (u32 n = t; !done; ++n)
+                    {
+                        u32 const i = n % numStable;
+                        failures += impl::findType(stable[i].c_str()) == infos[i] ? 0 : 1;
+                        failures += type_info_t::findByStableId(infos[i].getStableId()) == infos[i] ? 0 : 1;
+
+                        // a module type is found or not, but never as another type. It can be unloaded right after
+                        // it was found, its stable id only counts when it is still registered after reading it.
+                        std::string const &name     = module[n % numModule];
+                        u64 const          expected = impl::stableIdOf(name.c_str());
+                        type_info_t const  byName   = impl::findType(name.c_str());
+                        type_info_t const  byId     = type_info_t::findByStableId(expected);
+                        u64 const          nameId   = byName.getStableId();
+                        u64 const          stableId = byId.getStableId();
+                        failures += (nameId == 0 || nameId == expected || !byName.isRegistered()) ? 0 : 1;
+                        failures += (stableId == 0 || stableId == expected || !byId.isRegistered()) ? 0 : 1;
+                    }
+                }));
+            }
+            loader.join();
+            for (u32 t = 0; t < numThreads; ++t)
+                readers[t].join();
+            CHECK_EQUAL((u32)0, failures.load());
+            impl::popRegistry();
+        }
+    }
+
+    UNITTEST_FIXTURE(allocator)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(all_memory_comes_from_the_allocator)
+        {
+            std::vector<std::string> names;
+            make_names(names, "allocated", 1000);
+
+            counting_alloc_t allocator;
+            setRegistryAllocator(&allocator);
+            impl::pushRegistry();
+            setRegistryAllocator(nullptr);
+            u32 const afterPush = allocator.m_allocations;
+            CHECK_TRUE(afterPush > 0);
+
+            type_profile_entry_t const hot = {impl::stableIdOf(names[10].c_str()), 1, 1};
+            CHECK_TRUE(loadTypeProfile(&hot, 1));
+            std::vector<type_id_t> ids;
+            register_snapshot_types(names, ids);
+            type_info_t const dynamic = impl::registerOrGetDynamicType("allocated::dynamic", 18, type_info_t(), nullptr, 0);
+            CHECK_TRUE(sealRegistry());
+            CHECK_TRUE(unregisterType(dynamic));
+            {
+                derived_type_set_t const set(impl::findType(names[0].c_str()));
+                CHECK_TRUE(set.contains(ids[5]));
+            }
+            CHECK_TRUE(allocator.m_allocations > afterPush);
+
+            // a registry pushed now uses the system heap again
+            u32 const before = allocator.m_allocations;
+            impl::pushRegistry();
+            impl::registerOrGetType("allocated::elsewhere", type_info_t(), nullptr, 0);
+            impl::popRegistry();
+            CHECK_EQUAL(before, allocator.m_allocations);
+
+            impl::popRegistry();
+            CHECK_EQUAL((s32)0, allocator.m_live);
+        }
+    }
+
+    UNITTEST_FIXTURE(storage)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(grows_beyond_8192_types)
+        {
+            u32 const                numTypes = 20000;
+            std::vector<std::string> names;
+            make_names(names, "growing", numTypes);
+
+            impl::pushRegistry();
+
+            registry_stats_t empty;
+            getRegistryStats(empty);
+            CHECK_EQUAL((u32)1, empty.m_types);
+            CHECK_TRUE(empty.m_capacity < numTypes);
+            CHECK_TRUE(empty.m_bytes < 64 * 1024);
+
+            std::vector<type_id_t> ids(numTypes);
+            for (u32 i = 0; i < numTypes; ++i)
+            {
+                ids[i] = impl::registerOrGetType(names[i].c_str(), type_info_t(), nullptr, 0).getId();
+                CHECK_TRUE(ids[i] != 0);
+            }
+
+            // growing must not have moved any earlier type
+            u32 mismatches = 0;
+            for (u32 i = 0; i < numTypes; ++i)
+            {
+                type_info_t const info = impl::findType(names[i].c_str());
+                mismatches += (info.getId() != ids[i] || names[i] != info.getName()) ? 1 : 0;
+            }
+            CHECK_EQUAL((u32)0, mismatches);
+
+            registry_stats_t full;
+            getRegistryStats(full);
+            CHECK_EQUAL(numTypes + 1, full.m_types);
+            CHECK_TRUE(full.m_capacity >= full.m_types);
+            CHECK_TRUE(full.m_index_size >= full.m_types * 2);
+            CHECK_TRUE(full.m_bytes > empty.m_bytes);
+
+            impl::popRegistry();
+        }
+
+        UNITTEST_TEST(ids_use_the_full_width)
+        {
+#if RTTR_TYPE_ID_BITS == 32
+            u32 const numTypes = 100000;  // beyond the range of a 16-bit id
+#else
+            u32 const numTypes = 50000;  // beyond the range of a signed 16-bit id
+#endif
+            std::vector<std::string> names;
+            make_names(names, "wide", numTypes);
+
+            impl::pushRegistry();
+
+            std::vector<type_id_t> ids(numTypes);
+            u32                    failures = 0;
+            for (u32 i = 0; i < numTypes; ++i)
+            {
+                type_info_t const info = impl::registerOrGetType(names[i].c_str(), type_info_t(), nullptr, 0);
+                ids[i]                 = info.getId();
+                failures += (!info.isValid() || info.getId() != i + 1) ? 1 : 0;
+            }
+            CHECK_EQUAL((u32)0, failures);
+
+            // the last types must be found by name and compare as their own types, not as truncated ids
+            u32 mismatches = 0;
+            for (u32 i = 0; i < numTypes; ++i)
+            {
+                type_info_t const info = impl::findType(names[i].c_str());
+                mismatches += (info.getId() != ids[i] || names[i] != info.getName() || info.getRawType() != info) ? 1 : 0;
+            }
+            CHECK_EQUAL((u32)0, mismatches);
+
+            type_info_t const first = impl::findType(names[0].c_str());
+            type_info_t const last  = impl::findType(names[numTypes - 1].c_str());
+            CHECK_TRUE(first < last);
+            CHECK_TRUE(first != last);
+            CHECK_TRUE(type_info_t::findByStableId(last.getStableId()) == last);
+
+            impl::popRegistry();
+        }
+    }
+}
+UNITTEST_SUITE_END
@@ -207,6 +207,38 @@ UNITTEST_SUITE_BEGIN(crtti)
             }
         }
 
+        UNITTEST_TEST(TypeIdTests_DiamondClassInheritance)
+        {
+            ClassDiamondTop    top;
+            ClassDiamondOther& other = top;
+            ClassDiamondLeft&  left  = top;
+            ClassDiamondRight& right = top;
+
+            // down cast cast
+            CHECK_TRUE(rttr_cast<ClassDiamondTop*>(&other) != NULL);
+            CHECK_TRUE(rttr_cast<ClassDiamondTop*>(&left) != NULL);
+            CHECK_TRUE(rttr_cast<ClassDiamond*>(&right) != NULL);
+            CHECK_TRUE(rttr_cast<ClassDiamondOther*>(&other) != NULL);
+
+            // up cast cast
+            CHECK_TRUE(rttr_cast<ClassDiamondOther*>(&top) != NULL);
+            CHECK_TRUE(rttr_cast<ClassDiamond*>(&top) != NULL);
+            CHECK_TRUE(rttr_cast<ClassDiamondLeft*>(&top) != NULL);
+            CHECK_TRUE(rttr_cast<ClassDiamondRight*>(&top) != NULL);
+
+            // the base of the diamond is reached along two paths, a cast would be ambiguous
+            CHECK_TRUE(type_info_t::get(top).isTypeDerivedFrom<ClassDiamondBase>());
+            CHECK_TRUE(type_info_t::get<ClassDiamond>().isTypeDerivedFrom<ClassDiamondBase>());
+            CHECK_TRUE(type_info_t::get<ClassDiamondTop*>().isTypeDerivedFrom<ClassDiamondBase>());
+
+            // invalid casts
+            ClassDiamond diamond;
+            ClassDiamondLeft& diamondLeft = diamond;
+            CHECK_TRUE(rttr_cast<ClassDiamondTop*>(&diamondLeft) == NULL);
+            CHECK_FALSE(type_info_t::get<ClassDiamond>().isTypeDerivedFrom<ClassDiamondOther>());
+            CHECK_FALSE(type_info_t::get<ClassDiamondBase>().isTypeDerivedFrom<ClassDiamond>());
+        }
+
         UNITTEST_TEST(TypeIdTests_TypeIdAndClassInheritance)
         {
             ClassSingle6A    instance6A;
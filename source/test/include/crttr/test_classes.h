@@ -124,4 +124,30 @@ CLASS_MULTI_INHERIT_2(ClassMulti5A, ClassMulti4A, ClassMulti4B)
 CLASS_MULTI_INHERIT_2(ClassMulti6A, ClassMulti5A, ClassMulti5B)
 CLASS_MULTI_INHERIT_2(ClassMulti7A, ClassMulti6A, ClassMulti6B)
 
+/////////////////////////////////////////////////////////////////////////////////////////
+// The following class structure is a (non-virtual) diamond, which is reached again
+// through a second base class, so ClassDiamondBase is an ancestor along several paths
+/////////////////////////////////////////////////////////////////////////////////////////
+
+CLASS(ClassDiamondBase)
+CLASS_INHERIT(ClassDiamondLeft, ClassDiamondBase)
+CLASS_INHERIT(ClassDiamondRight, ClassDiamondBase)
+CLASS_MULTI_INHERIT_2(ClassDiamond, ClassDiamondLeft, ClassDiamondRight)
+
+CLASS(ClassDiamondOther)
+CLASS_MULTI_INHERIT_2(ClassDiamondTop, ClassDiamondOther, ClassDiamond)
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// The following class has more than 5 direct base classes, all single inheritance
+// chains above share ClassSingleBase
+/////////////////////////////////////////////////////////////////////////////////////////
+
+struct ClassWide : ClassSingle6A, ClassSingle6B, ClassSingle6C, ClassSingle6D, ClassSingle6E, ClassDiamondOther
+{
+    virtual int getType() { return 1; }
+    RTTR_ENABLE_DERIVED_FROM(ClassSingle6A, ClassSingle6B, ClassSingle6C, ClassSingle6D, ClassSingle6E, ClassDiamondOther)
+    bool dummyBoolValue;
+};
+RTTR_DECLARE_STANDARD_META_TYPE_VARIANTS(ClassWide)
+
 #endif // __RTTR_TESTCLASSES_H__